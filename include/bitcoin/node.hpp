@@ -34,10 +34,23 @@
 #include <bitcoin/node/sessions/session_inbound.hpp>
 #include <bitcoin/node/sessions/session_manual.hpp>
 #include <bitcoin/node/sessions/session_outbound.hpp>
+#include <bitcoin/node/utility/atomic_performance.hpp>
+#include <bitcoin/node/utility/block_requests.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/hash_batch.hpp>
+#include <bitcoin/node/utility/hash_heights.hpp>
 #include <bitcoin/node/utility/header_list.hpp>
+#include <bitcoin/node/utility/header_tree.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
+#include <bitcoin/node/utility/import_queue.hpp>
+#include <bitcoin/node/utility/locator_cache.hpp>
 #include <bitcoin/node/utility/performance.hpp>
+#include <bitcoin/node/utility/prevout_prefetch.hpp>
+#include <bitcoin/node/utility/rate_history.hpp>
+#include <bitcoin/node/utility/reorder_buffer.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
 #include <bitcoin/node/utility/reservations.hpp>
+#include <bitcoin/node/utility/size_profile.hpp>
+#include <bitcoin/node/utility/sync_journal.hpp>
 
 #endif
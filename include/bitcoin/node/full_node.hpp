@@ -28,7 +28,14 @@
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/sessions/session_block_sync.hpp>
 #include <bitcoin/node/sessions/session_header_sync.hpp>
+#include <bitcoin/node/utility/block_requests.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/header_tree.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
+#include <bitcoin/node/utility/locator_cache.hpp>
+#include <bitcoin/node/utility/prevout_prefetch.hpp>
+#include <bitcoin/node/utility/size_profile.hpp>
+#include <bitcoin/node/utility/sync_journal.hpp>
 
 // #ifdef WITH_KEOKEN
 // #include <bitprim/keoken/manager.hpp>
@@ -95,6 +102,8 @@ public:
     // ------------------------------------------------------------------------
 
     /// Idempotent call to signal work stop, start may be reinvoked after.
+    /// Saves the sync journal if sync is incomplete, and the bitmap of
+    /// populated heights.
     /// Returns the result of file save operation.
     bool stop() override;
 
@@ -115,6 +124,18 @@ public:
     /// Blockchain query interface.
     virtual blockchain::safe_chain& chain();
 
+    /// Tree of headers announced by all channels, above the chain top.
+    virtual header_tree& headers();
+
+    /// Table of blocks in flight across all channels.
+    virtual block_requests& requests();
+
+    /// Block locator of the chain top, empty if not built.
+    virtual locator_cache& locator();
+
+    /// Prefetcher of the previous outputs of blocks being assembled.
+    virtual prevout_prefetch& prevouts();
+
     /// Blockchain.
     //TODO: remove this function and use safe_chain in the rpc lib
     virtual blockchain::block_chain& chain_bitprim();
@@ -171,8 +192,17 @@ private:
     void handle_started(const code& ec, result_handler handler);
     void handle_running(const code& ec, result_handler handler);
 
+    void prefetch_output(const chain::output_point& point) const;
+
     // These are thread safe.
     check_list hashes_;
+    height_bitmap populated_;
+    sync_journal journal_;
+    size_profile sizes_;
+    header_tree headers_;
+    block_requests requests_;
+    locator_cache locator_;
+    prevout_prefetch prevouts_;
     //blockchain::block_chain chain_;
     const uint32_t protocol_maximum_;
     const node::settings& node_settings_;
@@ -22,7 +22,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <queue>
+#include <unordered_map>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
@@ -52,7 +52,7 @@ public:
     virtual void start();
 
 private:
-    typedef std::queue<hash_digest> hash_queue;
+    typedef std::unordered_map<hash_digest, asio::time_point> request_map;
 
     static void report(const chain::block& block);
 
@@ -70,11 +70,15 @@ private:
     void handle_fetch_block_locator_compact_block(const code& ec, get_headers_ptr message, const hash_digest& stop_hash);
 
     void send_get_data_compact_block(const code& ec, const hash_digest& hash);
+    bool is_reconstructed(const chain::header& header,
+        const chain::transaction::list& transactions) const;
 
     void handle_timeout(const code& ec);
     void handle_stop(const code& ec);
 
     void organize_block(block_const_ptr message);
+    void skip_block(const hash_digest& hash);
+    void reclaim_blocks();
 
     // These are thread safe.
     full_node& node_;
@@ -86,8 +90,8 @@ private:
     const bool require_witness_;
     const bool peer_witness_;
 
-    // This is protected by mutex.
-    hash_queue backlog_;
+    // This is protected by mutex, the time of each block request by hash.
+    request_map requested_;
     mutable upgrade_mutex mutex;
 
     compact_block_map compact_blocks_map_;
@@ -19,8 +19,10 @@
 #ifndef LIBBITCOIN_NODE_PROTOCOL_HEADER_SYNC_HPP
 #define LIBBITCOIN_NODE_PROTOCOL_HEADER_SYNC_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <vector>
 #include <bitcoin/network.hpp>
@@ -42,14 +44,15 @@ public:
 
     /// Construct a header sync protocol instance.
     protocol_header_sync(full_node& network, network::channel::ptr channel,
-        header_list::ptr headers, uint32_t minimum_rate);
+        header_list::ptr headers);
 
     /// Start the protocol.
     virtual void start(event_handler handler);
 
 private:
-    void send_get_headers(event_handler complete);
+    void send_get_headers(const hash_digest& anchor);
     void handle_event(const code& ec, event_handler complete);
+    bool handle_lost_round(event_handler complete);
     void headers_complete(const code& ec, event_handler handler);
     bool handle_receive_headers(const code& ec, headers_const_ptr message,
         event_handler complete);
@@ -57,11 +60,12 @@ private:
     // Thread safe and guarded by sequential header sync.
     header_list::ptr headers_;
 
-    // This is guarded by protocol_timer/deadline contract (exactly one call).
-    size_t current_second_;
+    // These are guarded by the sequential message handling of this peer.
+    std::deque<hash_digest> anchors_;
+    size_t losses_;
 
-    const uint32_t minimum_rate_;
-    const size_t start_size_;
+    // This is incremented by responses and cleared by the timer.
+    std::atomic<size_t> responses_;
 };
 
 } // namespace node
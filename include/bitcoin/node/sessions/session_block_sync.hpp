@@ -19,6 +19,7 @@
 #ifndef LIBBITCOIN_NODE_SESSION_BLOCK_SYNC_HPP
 #define LIBBITCOIN_NODE_SESSION_BLOCK_SYNC_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -28,8 +29,11 @@
 #include <bitcoin/node/sessions/session.hpp>
 #include <bitcoin/node/settings.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
 #include <bitcoin/node/utility/reservations.hpp>
+#include <bitcoin/node/utility/size_profile.hpp>
+#include <bitcoin/node/utility/sync_journal.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -44,6 +48,7 @@ public:
     typedef std::shared_ptr<session_block_sync> ptr;
 
     session_block_sync(full_node& network, check_list& hashes,
+        sync_journal& journal, height_bitmap& populated, size_profile& sizes,
         blockchain::fast_chain& chain, const settings& settings);
 
     void start(result_handler handler) override;
@@ -74,11 +79,24 @@ private:
     // Timers.
     void reset_timer();
     void handle_timer(const code& ec);
+    void regulate();
 
     // These are thread safe.
     blockchain::fast_chain& chain_;
+    sync_journal& journal_;
+    const size_t journal_ticks_;
     reservations reservations_;
     deadline::ptr timer_;
+
+    // This is set before any connection is started.
+    result_handler complete_;
+
+    // This is set once the reservation table is emptied.
+    std::atomic<bool> completed_;
+
+    // These are protected by the sequential timer.
+    double throughput_;
+    size_t ticks_;
 };
 
 } // namespace node
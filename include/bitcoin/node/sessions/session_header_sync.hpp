@@ -30,6 +30,7 @@
 #include <bitcoin/node/settings.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
 #include <bitcoin/node/utility/header_list.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -44,8 +45,9 @@ public:
     typedef std::shared_ptr<session_header_sync> ptr;
 
     session_header_sync(full_node& network, check_list& hashes,
-        blockchain::fast_chain& blockchain,
-        const config::checkpoint::list& checkpoints);
+        height_bitmap& populated, blockchain::fast_chain& blockchain,
+        const config::checkpoint::list& checkpoints,
+        const settings& settings);
 
     virtual void start(result_handler handler) override;
 
@@ -62,6 +64,7 @@ private:
     typedef std::vector<header_list::ptr> headers_table;
 
     bool initialize();
+    void initialize_slots(size_t first_height);
 
     void handle_started(const code& ec, result_handler handler);
 
@@ -84,12 +87,13 @@ private:
 
     // Thread safe.
     check_list& hashes_;
+    height_bitmap& populated_;
 
     // These do not require guard because they are not used concurrently.
     headers_table headers_;
-    uint32_t minimum_rate_;
     blockchain::fast_chain& chain_;
     const config::checkpoint::list checkpoints_;
+    const size_t slots_;
 };
 
 } // namespace node
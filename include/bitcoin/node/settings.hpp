@@ -36,6 +36,8 @@ public:
     /// Properties.
     uint32_t sync_peers;
     uint32_t sync_timeout_seconds;
+    uint32_t sync_window;
+    bool sync_relaxed;
     uint32_t block_latency_seconds;
     bool refresh_transactions;
 
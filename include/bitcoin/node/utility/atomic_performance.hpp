@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_ATOMIC_PERFORMANCE_HPP
+#define LIBBITCOIN_NODE_ATOMIC_PERFORMANCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/performance.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A performance record published to readers through a sequence lock.
+/// Readers never block, writers must be serialized by the caller.
+class BCN_API atomic_performance
+{
+public:
+    /// Construct with the specified initial record.
+    atomic_performance(const performance& value);
+
+    /// A consistent copy of the record, retrying over a concurrent store.
+    performance load() const;
+
+    /// The idle state of the record.
+    bool idle() const;
+
+    /// Publish the record, with stores serialized by the caller.
+    void store(const performance& value);
+
+private:
+    // Odd while a store is in progress.
+    std::atomic<uint32_t> sequence_;
+
+    std::atomic<bool> idle_;
+    std::atomic<size_t> events_;
+    std::atomic<uint64_t> database_;
+    std::atomic<uint64_t> window_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
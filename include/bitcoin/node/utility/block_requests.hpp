@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_BLOCK_REQUESTS_HPP
+#define LIBBITCOIN_NODE_BLOCK_REQUESTS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A thread safe table of blocks in flight across all channels, so that each
+/// block is requested from one peer at a time, up to a limit per peer.
+/// Peers that announce a block held by another peer wait on it, and take it
+/// over once the holder times out or releases it.
+class BCN_API block_requests
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /// Allow up to limit blocks in flight per peer, each for timeout.
+    block_requests(size_t limit, clock::duration timeout);
+
+    /// The number of blocks in flight or awaiting a peer.
+    size_t size() const;
+
+    /// The number of blocks in flight from the peer.
+    size_t count(uint64_t peer) const;
+
+    /// Assign the announced hashes to the peer where not held by another
+    /// peer within its timeout, up to the limit, appending them to out in
+    /// announcement order. The peer waits on the remaining hashes.
+    void claim(uint64_t peer, const hash_list& hashes, hash_list& out,
+        clock::time_point now=clock::now());
+
+    /// Assign the released or timed out hashes on which the peer waits, up
+    /// to the limit, appending them to out in announcement order.
+    void reclaim(uint64_t peer, hash_list& out,
+        clock::time_point now=clock::now());
+
+    /// Remove the block, received from any peer.
+    /// Return true if it was in flight from the peer.
+    bool complete(uint64_t peer, const hash_digest& hash);
+
+    /// Release the blocks held by the peer to its waiters and stop waiting.
+    void release(uint64_t peer);
+
+private:
+    struct flight
+    {
+        size_t sequence;
+        bool assigned;
+        uint64_t peer;
+        clock::time_point since;
+        std::vector<uint64_t> waiters;
+    };
+
+    typedef std::unordered_map<hash_digest, flight> flights;
+
+    // Assign the flight to the peer if within its limit.
+    bool assign(flight& value, uint64_t peer, clock::time_point now);
+
+    // Clear the assignment of the flight.
+    void unassign(flight& value);
+
+    // These are protected by mutex.
+    flights flights_;
+    std::unordered_map<uint64_t, size_t> counts_;
+    size_t sequence_;
+    const size_t limit_;
+    const clock::duration timeout_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -20,16 +20,17 @@
 #define LIBBITCOIN_NODE_CHECK_LIST_HPP
 
 #include <cstddef>
-#include <boost/bimap.hpp>
-#include <boost/bimap/set_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
+#include <cstdint>
+#include <vector>
 #include <bitcoin/database.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/size_profile.hpp>
 
 namespace libbitcoin {
 namespace node {
 
 /// A thread safe checkpoint queue.
+/// Entries are held in a contiguous span indexed by height.
 class BCN_API check_list
 {
 public:
@@ -42,6 +43,8 @@ public:
     using heights = std::vector<size_t>;
 #endif // BITPRIM_DB_NEW
 
+    check_list();
+
     /// The queue contains no checkpoints.
     bool empty() const;
 
@@ -58,13 +61,37 @@ public:
     /// Remove the next entry by increasing height.
     bool dequeue(hash_digest& out_hash, size_t& out_height);
 
+    /// Remove up to count entries by increasing height, appending to out.
+    size_t dequeue(config::checkpoint::list& out, size_t count);
+
+    /// Remove up to count entries by increasing height, appending to out,
+    /// stopping once their estimated sizes reach the byte budget.
+    /// At least one entry is removed unless the queue is empty.
+    size_t dequeue(config::checkpoint::list& out, size_t count,
+        uint64_t budget, const size_profile& profile);
+
+    /// Return a dequeued entry to the queue.
+    void restore(hash_digest&& hash, size_t height);
+
+    /// Remove the entry at the height if it is queued.
+    bool take(hash_digest& out_hash, size_t height);
+
+    /// Copy all entries by increasing height, including those without hash.
+    void snapshot(config::checkpoint::list& out) const;
+
+    /// The lowest height of an entry without hash, false if none.
+    bool missing(size_t& out_height) const;
+
 private:
-    // A bidirection map is used for efficient hash and height retrieval.
-    typedef boost::bimaps::bimap<
-        boost::bimaps::unordered_set_of<hash_digest>,
-        boost::bimaps::set_of<size_t>> checks;
+    // Advance the cursor to the next reserved entry.
+    void seek();
 
-    checks checks_;
+    // These are protected by mutex.
+    std::vector<hash_digest> hashes_;
+    std::vector<bool> reserved_;
+    size_t base_;
+    size_t cursor_;
+    size_t count_;
     mutable shared_mutex mutex_;
 };
 
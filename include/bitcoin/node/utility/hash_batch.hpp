@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_HASH_BATCH_HPP
+#define LIBBITCOIN_NODE_HASH_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Batched bitcoin hash (double sha256) engine, thread safe.
+/// The multi-lane kernel is selected at runtime from processor support.
+class BCN_API hash_batch
+{
+public:
+    enum class kernel
+    {
+        /// Portable, one message at a time.
+        scalar,
+
+        /// Eight messages at a time in 256 bit vector lanes.
+        avx2,
+
+        /// One message at a time with the x86 sha extensions.
+        shani
+    };
+
+    /// Construct an engine using the fastest supported kernel.
+    hash_batch();
+
+    /// Construct an engine using the specified kernel if it is supported,
+    /// otherwise using the scalar kernel.
+    hash_batch(kernel engine);
+
+    /// The kernel used by this engine.
+    kernel engine() const;
+
+    /// The kernel is supported by this processor.
+    static bool supported(kernel engine);
+
+    /// The fastest kernel supported by this processor.
+    static kernel fastest();
+
+    /// Set each out hash to the bitcoin hash of the corresponding message.
+    void hash(hash_digest* out, const uint8_t* const* messages,
+        const size_t* sizes, size_t count) const;
+
+    /// Set each out hash to the bitcoin hash of a fixed size message, where
+    /// the messages are contiguous in data.
+    void hash(hash_digest* out, const uint8_t* data, size_t size,
+        size_t count) const;
+
+    /// The hashes of the headers.
+    hash_list hash(const chain::header::list& headers) const;
+
+    /// The hashes (txids) of the transactions.
+    hash_list hash(const chain::transaction::list& transactions) const;
+
+    /// The merkle root of the hashes, hashing each tree level as a batch.
+    hash_digest merkle_root(hash_list hashes) const;
+
+private:
+    const kernel engine_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
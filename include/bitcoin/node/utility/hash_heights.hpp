@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_HASH_HEIGHTS_HPP
+#define LIBBITCOIN_NODE_HASH_HEIGHTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A height ordered set of block hashes with a flat open addressing index
+/// from hash to entry, not thread safe.
+class BCN_API hash_heights
+{
+public:
+    hash_heights();
+
+    /// There are no entries.
+    bool empty() const;
+
+    /// The number of entries.
+    size_t size() const;
+
+    /// The number of entries marked as requested.
+    size_t requested() const;
+
+    /// The entry of the lowest height, false if empty.
+    bool front(hash_digest& out_hash, size_t& out_height,
+        bool& out_requested) const;
+
+    /// Remove all entries.
+    void clear();
+
+    /// Add the hash at the height, which usually exceeds any present height.
+    void insert(const hash_digest& hash, size_t height);
+
+    /// Add the entries of the other set as unrequested, sorting at most once.
+    void merge(const hash_heights& other);
+
+    /// Remove the entry of the hash and return true if it is found.
+    bool erase(const hash_digest& hash, size_t& out_height);
+
+    /// Mark up to count unrequested entries not above the ceiling height as
+    /// requested, in height order, appending their hashes to out.
+    void request(size_t count, hash_list& out, size_t ceiling=max_size_t);
+
+    /// Mark all entries as unrequested.
+    void reset_requests();
+
+    /// Move up to count entries of the lowest heights to the other set.
+    /// Moved entries are unrequested in the other set.
+    void move_front(hash_heights& other, size_t count);
+
+    /// Move up to count unrequested entries of the highest heights to the
+    /// other set, leaving requested entries in place.
+    void move_back(hash_heights& other, size_t count);
+
+    /// Call visitor(hash, height) for each entry in height order.
+    template <typename Visitor>
+    void visit(Visitor visitor) const
+    {
+        for (auto position = first_; position < entries_.size(); ++position)
+        {
+            const auto& entry = entries_[position];
+
+            if (entry.live)
+                visitor(entry.hash, entry.height);
+        }
+    }
+
+private:
+    struct entry
+    {
+        hash_digest hash;
+        size_t height;
+        bool live;
+        bool requested;
+    };
+
+    // Append an unindexed entry, returning false if it is out of order.
+    bool append(const hash_digest& hash, size_t height);
+
+    // Index the entries appended from start, sorting them in if unordered.
+    void settle(size_t start, bool ordered);
+
+    // Find the position of the live entry of the hash, or return npos.
+    size_t find(const hash_digest& hash) const;
+
+    // The index slot at which the probe for the hash begins.
+    size_t bucket(const hash_digest& hash) const;
+
+    // Add the position to the index, which must have a vacant slot.
+    void index(size_t position);
+
+    // Drop erased entries and rebuild the index to fit the entries.
+    void compact();
+
+    std::vector<entry> entries_;
+    std::vector<uint32_t> index_;
+    size_t first_;
+    size_t live_;
+    size_t requested_;
+    size_t indexed_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
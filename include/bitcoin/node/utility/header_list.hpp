@@ -29,7 +29,9 @@ namespace libbitcoin {
 namespace node {
 
 /// A smart queue for chaining blockchain headers, thread safe.
-/// The peer should be stopped if merge fails.
+/// Validated header hashes are streamed to the check list in chunks, so only
+/// the most recent chunk is held in memory. The peer should be stopped if
+/// merge fails.
 class BCN_API header_list
 {
 public:
@@ -37,7 +39,7 @@ public:
 
     /// Construct a list to fill the specified range of headers.
     header_list(size_t slot, const config::checkpoint& start,
-        const config::checkpoint& stop);
+        const config::checkpoint& stop, check_list& hashes);
 
     /// The list is fully populated.
     bool complete() const;
@@ -57,35 +59,38 @@ public:
     /// The hash of the stop checkpoint.
     const hash_digest& stop_hash() const;
 
-    /// The ordered list of headers.
-    /// This is not thread safe, call only after complete.
-    const chain::header::list& headers() const;
-
-    /////// Generate a check list from a complete list of headers.
-    ////config::checkpoint::list to_checkpoints() const;
-
     /// Merge the hashes in the message with those in the queue.
-    /// Return true if linked all headers or complete.
-    bool merge(headers_const_ptr message);
+    /// Return true if linked all headers or complete. If the message does not
+    /// extend the last header nothing is merged and overtaken is set.
+    bool merge(headers_const_ptr message, bool& overtaken);
 
 private:
     // The number of headers remaining until complete.
     size_t remaining() const;
 
-    /// The hash of the last header in the list (or the start hash).
-    const hash_digest& last() const;
-
     // Determine if the hash is linked to the preceding header.
-    bool link(const chain::header& header) const;
+    bool link(const chain::header& header,
+        const hash_digest& previous) const;
 
     // Determine if the header is valid (context free).
-    bool check(const chain::header& header) const;
+    bool check(const chain::header& header, const hash_digest& hash) const;
+
+    // Determine if the header is acceptable for its height.
+    bool accept(const hash_digest& hash, size_t height) const;
+
+    // Store the pending chunk of hashes to the check list.
+    void flush();
+
+    // Discard all headers, restarting from the start checkpoint.
+    void reset();
 
-    // Determine if the header is acceptable for the current height.
-    bool accept(const chain::header& header) const;
+    // Thread safe.
+    check_list& hashes_;
 
-    // This is protected by mutex.
-    chain::header::list list_;
+    // These are protected by mutex.
+    hash_list list_;
+    hash_digest last_;
+    size_t count_;
     mutable upgrade_mutex mutex_;
 
     const size_t height_;
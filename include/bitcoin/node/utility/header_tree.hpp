@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_HEADER_TREE_HPP
+#define LIBBITCOIN_NODE_HEADER_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A thread safe tree of announced block headers rooted in the tail of the
+/// block chain, tracking the chainwork of each branch and the best tip
+/// announced by each peer. Work is relative to the anchor of the tree.
+/// The headers added by each peer and in total are bounded, with branches of
+/// no more work than the chain dropped first once a bound is reached.
+class BCN_API header_tree
+{
+public:
+    enum class status
+    {
+        /// The headers link to the tree (any blocks to fetch are returned).
+        accepted,
+
+        /// The first header does not link to the tree.
+        orphan,
+
+        /// A header fails its proof of work or timestamp check.
+        invalid,
+
+        /// The peer or the tree holds its maximum of headers.
+        saturated
+    };
+
+    /// Retain headers within depth blocks of the chain top, up to maximum
+    /// in total and peer maximum added by any one peer. If bounded, the
+    /// target of a header may not exceed that of its parent by more than the
+    /// retargeting factor.
+    header_tree(size_t depth, size_t maximum, size_t peer_maximum,
+        bool bounded);
+
+    /// The number of headers in the tree.
+    size_t size() const;
+
+    /// Reset the tree to the chain top, of which the header is not required.
+    void anchor(const hash_digest& hash, size_t height);
+
+    /// Mark the header as the chain top at the height, linking it to the
+    /// tree. The tree is anchored at the header if its parent is unknown.
+    void connect(const chain::header& header, size_t height);
+
+    /// Remove the block of the hash from the chain, leaving it as a branch.
+    void disconnect(const hash_digest& hash);
+
+    /// Add sequential headers announced by the peer, setting its best tip.
+    /// If the last header leaves its branch with more work than the chain,
+    /// out_fetch receives the branch hashes not in the chain, by height.
+    status add(uint64_t peer, const chain::header::list& headers,
+        hash_list& out_fetch);
+
+    /// The best tip announced by the peer, false if none is known.
+    bool tip(uint64_t peer, hash_digest& out_hash, size_t& out_height) const;
+
+    /// Forget the best tip of the peer.
+    void remove(uint64_t peer);
+
+private:
+    struct entry
+    {
+        hash_digest previous;
+        size_t height;
+        uint256_t work;
+        uint32_t bits;
+        bool chain;
+        bool owned;
+        uint64_t peer;
+    };
+
+    typedef std::unordered_map<hash_digest, entry> entries;
+
+    // The header is within its target, which is within the limit.
+    static bool check(const chain::header& header, const hash_digest& hash);
+
+    // The target of the bits is within a retarget step of the parent bits.
+    bool step(uint32_t bits, uint32_t parent) const;
+
+    // The number of headers added by the peer that remain in the tree.
+    size_t owned(uint64_t peer) const;
+
+    // Erase the entry, releasing it from the peer that added it.
+    entries::iterator erase(entries::iterator it);
+
+    // Drop branches with no more work than the chain, and the tips on them.
+    void evict();
+
+    // Set the branch of the tip above the chain, by height, false if the
+    // branch does not reach the chain.
+    bool branch(const hash_digest& tip, hash_list& out) const;
+
+    // Drop headers more than depth below the chain top.
+    void prune();
+
+    // Thread safe.
+    const size_t depth_;
+    const size_t maximum_;
+    const size_t peer_maximum_;
+    const bool bounded_;
+
+    // These are protected by mutex.
+    entries entries_;
+    std::unordered_map<uint64_t, hash_digest> tips_;
+    std::unordered_map<uint64_t, size_t> owned_;
+    hash_digest top_;
+    size_t top_height_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
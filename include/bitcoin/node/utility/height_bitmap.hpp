@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_HEIGHT_BITMAP_HPP
+#define LIBBITCOIN_NODE_HEIGHT_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A bitmap of the populated block heights of the store, thread safe.
+/// The file is only valid while it matches the bitmap, so that a bitmap
+/// changed after its last save is rebuilt from a store scan on restart.
+class BCN_API height_bitmap
+{
+public:
+    typedef std::vector<size_t> heights;
+
+    /// Construct an empty bitmap persisted to the file.
+    height_bitmap(const boost::filesystem::path& file);
+
+    /// The bitmap was loaded or assigned and so reflects the store.
+    bool valid() const;
+
+    /// Read the file, false if it is missing, invalid or of another top.
+    bool load(size_t top);
+
+    /// Write the file for the top height, false if not valid.
+    bool save(size_t top);
+
+    /// Populate all heights through top except for the gaps.
+    void assign(const heights& gaps, size_t top);
+
+    /// Mark the height as populated.
+    void set(size_t height);
+
+    /// Mark the height as empty.
+    void reset(size_t height);
+
+    /// The height is populated.
+    bool contains(size_t height) const;
+
+    /// The number of populated heights.
+    size_t count() const;
+
+    /// Append the empty heights through top in increasing order.
+    void gaps(heights& out, size_t top) const;
+
+private:
+    // Remove the file once the bitmap differs from it.
+    void invalidate();
+
+    // Thread safe.
+    const boost::filesystem::path file_;
+
+    // These are protected by mutex.
+    bool valid_;
+    bool saved_;
+    std::vector<uint64_t> words_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
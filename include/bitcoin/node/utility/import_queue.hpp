@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_IMPORT_QUEUE_HPP
+#define LIBBITCOIN_NODE_IMPORT_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A multiple producer queue of jobs run on dedicated threads, thread safe.
+/// Jobs run in order when there is one thread, otherwise concurrently.
+/// Producers are expected to pause once it is full.
+class BCN_API import_queue
+{
+public:
+    typedef std::function<void()> job;
+
+    /// Construct a stopped queue that is full at the specified job count,
+    /// to be run on the specified number of threads (at least one).
+    import_queue(size_t capacity, size_t threads=1);
+
+    /// Run all queued jobs and stop the threads.
+    ~import_queue();
+
+    /// Start the threads, false if already started.
+    bool start();
+
+    /// Run all queued jobs and join the threads.
+    /// Must not be called from a job.
+    void stop();
+
+    /// The number of jobs not yet completed.
+    size_t size() const;
+
+    /// The number of jobs not yet completed has reached capacity.
+    bool full() const;
+
+    /// Queue the job, never blocking. If the queue is not started, or is
+    /// stopping, the job is run on the calling thread.
+    void push(job&& handler);
+
+    /// Queue the job, never blocking. If the queue is not started, or is
+    /// stopping, the job is dropped and false is returned.
+    bool try_push(job&& handler);
+
+private:
+    // The worker thread loop.
+    void run();
+
+    // These are protected by mutex.
+    std::deque<job> jobs_;
+    size_t pending_;
+    bool started_;
+    bool stopping_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+
+    // This is protected by the start and stop sequence.
+    std::vector<std::thread> threads_;
+
+    // Thread safe.
+    const size_t capacity_;
+    const size_t thread_count_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
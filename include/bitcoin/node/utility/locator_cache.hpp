@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_LOCATOR_CACHE_HPP
+#define LIBBITCOIN_NODE_LOCATOR_CACHE_HPP
+
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A thread safe block locator of the chain top, rebuilt from the store as
+/// the top changes so that a locator request requires no store access.
+/// The locator holds the hashes of the top ten heights, and then of heights
+/// at doubling distances below the top, down to genesis.
+class BCN_API locator_cache
+{
+public:
+    /// The cache is not built.
+    bool empty() const;
+
+    /// Discard the cache.
+    void clear();
+
+    /// Build the cache from the store at its top, false on failure.
+    bool rebuild(const blockchain::fast_chain& chain);
+
+    /// The locator hashes from the top down to genesis, empty if not built.
+    hash_list hashes() const;
+
+private:
+    // These are protected by mutex.
+    hash_list hashes_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
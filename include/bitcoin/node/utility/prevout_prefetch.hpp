@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_PREVOUT_PREFETCH_HPP
+#define LIBBITCOIN_NODE_PREVOUT_PREFETCH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/import_queue.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Looks up the previous outputs of transactions on worker threads ahead of
+/// block validation, so that the store pages they read are in memory once
+/// validation populates them. Lookups are advisory and dropped when the
+/// workers fall behind, thread safe.
+class BCN_API prevout_prefetch
+{
+public:
+    typedef std::function<void(const chain::output_point&)> lookup;
+
+    /// Construct a stopped prefetcher, running the lookup on the specified
+    /// number of threads, with up to capacity batches of lookups queued.
+    prevout_prefetch(lookup&& handler, size_t capacity, size_t threads);
+
+    /// Start the threads, false if already started.
+    bool start();
+
+    /// Complete queued lookups and stop the threads.
+    void stop();
+
+    /// Queue lookups of the previous outputs of the valid non-coinbase
+    /// transactions, in batches. Return the number of lookups queued, which
+    /// is zero if stopped.
+    size_t prefetch(const chain::transaction::list& transactions);
+
+private:
+    // Queue the batch of lookups if started with room, false if not.
+    bool push(chain::output_point::list&& batch);
+
+    // This is thread safe.
+    const lookup lookup_;
+    import_queue queue_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_RATE_HISTORY_HPP
+#define LIBBITCOIN_NODE_RATE_HISTORY_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A fixed capacity ring of import records with running sums, not thread
+/// safe. When full the oldest record is dropped to make room.
+class BCN_API rate_history
+{
+public:
+    typedef std::chrono::high_resolution_clock::time_point time_point;
+
+    /// Construct an empty history, allocating the specified capacity.
+    rate_history(size_t capacity);
+
+    /// There are no records.
+    bool empty() const;
+
+    /// The number of records.
+    size_t size() const;
+
+    /// The sum of events across records.
+    size_t events() const;
+
+    /// The sum of database cost across records.
+    uint64_t database() const;
+
+    /// The time of the oldest record, undefined if empty.
+    time_point front() const;
+
+    /// Remove all records.
+    void clear();
+
+    /// Remove records older than start and return true if any were removed.
+    bool expire(const time_point& start);
+
+    /// Append a record, dropping the oldest if at capacity.
+    void push(size_t events, uint64_t database, const time_point& time);
+
+private:
+    typedef struct
+    {
+        size_t events;
+        uint64_t database;
+        time_point time;
+    } record;
+
+    // Remove the oldest record.
+    void pop();
+
+    std::vector<record> records_;
+    size_t head_;
+    size_t size_;
+    size_t events_;
+    uint64_t database_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
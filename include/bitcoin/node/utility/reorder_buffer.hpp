@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_REORDER_BUFFER_HPP
+#define LIBBITCOIN_NODE_REORDER_BUFFER_HPP
+
+#include <cstddef>
+#include <map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A buffer of blocks accepted in any height order and released strictly in
+/// height order, thread safe.
+class BCN_API reorder_buffer
+{
+public:
+    /// Construct a buffer that releases blocks from the specified height and
+    /// is saturated at the specified number of buffered bytes.
+    reorder_buffer(size_t next_height, size_t capacity);
+
+    /// The height of the next block to be released.
+    size_t next() const;
+
+    /// The number of buffered blocks.
+    size_t size() const;
+
+    /// The serialized size of the buffered blocks.
+    size_t bytes() const;
+
+    /// The buffered bytes have reached capacity.
+    bool saturated() const;
+
+    /// Buffer the block at the height, false if released or already present.
+    bool push(block_const_ptr block, size_t height);
+
+    /// Release the block at the next height if present, otherwise null.
+    block_const_ptr pop(size_t& out_height);
+
+    /// Return the last released block to the buffer, resetting the next
+    /// height to its height, false if it was not the last released.
+    bool restore(block_const_ptr block, size_t height);
+
+private:
+    typedef struct
+    {
+        block_const_ptr block;
+        size_t size;
+    } entry;
+
+    // These are protected by mutex.
+    std::map<size_t, entry> blocks_;
+    size_t next_;
+    size_t bytes_;
+    mutable upgrade_mutex mutex_;
+
+    // Thread safe.
+    const size_t capacity_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -19,17 +19,19 @@
 #ifndef LIBBITCOIN_NODE_RESERVATION_HPP
 #define LIBBITCOIN_NODE_RESERVATION_HPP
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
-#include <boost/bimap.hpp>
-#include <boost/bimap/set_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/atomic_performance.hpp>
+#include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/hash_heights.hpp>
 #include <bitcoin/node/utility/performance.hpp>
+#include <bitcoin/node/utility/rate_history.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -44,9 +46,10 @@ public:
     typedef std::shared_ptr<reservation> ptr;
     typedef std::vector<reservation::ptr> list;
 
-    /// Construct a block reservation with the specified identifier.
+    /// Construct a block reservation with the specified identifier, limited
+    /// to window blocks in flight.
     reservation(reservations& reservations, size_t slot,
-        uint32_t sync_timeout_seconds);
+        uint32_t sync_timeout_seconds, size_t window);
 
     /// Ensure there are no remaining reserved hashes.
     ~reservation();
@@ -60,6 +63,9 @@ public:
     /// The number of outstanding blocks.
     size_t size() const;
 
+    /// The number of outstanding blocks that have not been requested.
+    size_t unrequested() const;
+
     /// The reservation is empty and will remain so.
     bool stopped() const;
 
@@ -78,31 +84,65 @@ public:
     /// The current cached average block import rate excluding import time.
     void set_rate(performance&& rate);
 
-    /// The block data request message for the outstanding block hashes.
-    /// Set new if the preceding request was unsuccessful or discarded.
+    /// Remove the rate from the table summary, which ignores later updates.
+    /// Call once the reservation is removed from the table.
+    void withdraw_rate();
+
+    /// The time without an arrival after which requested blocks are stalled,
+    /// derived from the measured rate of this reservation.
+    std::chrono::microseconds stall_timeout() const;
+
+    /// True if blocks are requested and none has arrived within the timeout.
+    bool stalled() const;
+
+    /// The lowest outstanding hash, false if empty.
+    bool front(hash_digest& out_hash, size_t& out_height,
+        bool& out_requested) const;
+
+    /// The block data request message to refill the window of blocks in
+    /// flight. Set new if the preceding requests were unsuccessful or
+    /// discarded, in which case all outstanding hashes are requestable.
     message::get_data request(bool new_channel);
 
     /// Add the block hash to the reservation.
     void insert(hash_digest&& hash, size_t height);
 
-    /// Add to the blockchain, with height determined by the reservation.
+    /// Add the block hashes to the reservation as unrequested.
+    void insert(const hash_heights& hashes);
+
+    /// Remove the block hash without import, true if it was found.
+    bool discard(const hash_digest& hash);
+
+    /// Queue the block for storage, with height determined by the
+    /// reservation, and repopulate if emptied.
     void import(block_const_ptr block);
 
-    /// Determine if the reservation was partitioned and reset partition flag.
-    bool toggle_partitioned();
+    /// Add to the blockchain at the height and record the store cost.
+    void store(block_const_ptr block, size_t height);
+
+    /// Flag a block that failed its checks, its hash is returned by the table.
+    void reject(block_const_ptr block, size_t height, const code& ec);
 
-    /// Move half of the reservation to the specified reservation.
+    /// Determine if a block was rejected and reset the rejected flag.
+    bool toggle_rejected();
+
+    /// Move half of the unrequested hashes to the specified reservation.
+    /// The hash locks of both are taken, that of the lower slot first.
     bool partition(reservation::ptr minimal);
 
     /// If not stopped and if empty try to get more hashes.
     void populate();
 
-protected:
-    // Accessor for testability.
-    bool pending() const;
+    /// Move unrequested hashes to out and stop repopulation.
+    /// The reservation stops once the blocks in flight are imported.
+    void retire(hash_heights& out_hashes);
+
+    /// The reservation has been retired.
+    bool retired() const;
 
+protected:
     // Accessor for testability.
-    void set_pending(bool value);
+    size_t requested() const;
 
     // Accessor for validating construction.
     std::chrono::microseconds rate_window() const;
@@ -111,20 +151,6 @@ protected:
     virtual std::chrono::high_resolution_clock::time_point now() const;
 
 private:
-    typedef struct
-    {
-        size_t events;
-        uint64_t database;
-        std::chrono::high_resolution_clock::time_point time;
-    } import_record;
-
-    typedef std::vector<import_record> rate_history;
-
-    // A bidirection map is used for efficient hash and height retrieval.
-    typedef boost::bimaps::bimap<
-        boost::bimaps::unordered_set_of<hash_digest>,
-        boost::bimaps::set_of<size_t>> hash_heights;
-
     // Return rate history to startup state.
     void clear_history();
 
@@ -134,8 +160,9 @@ private:
     // Update rate history to reflect an additional block of the given size.
     void update_rate(size_t events, const std::chrono::microseconds& database);
 
-    // Protected by rate mutex.
-    performance rate_;
+    // Read lock free, stores and the summary flag protected by rate mutex.
+    atomic_performance rate_;
+    bool summarized_;
     mutable upgrade_mutex rate_mutex_;
 
     // Protected by history mutex.
@@ -147,14 +174,16 @@ private:
     mutable upgrade_mutex stop_mutex_;
 
     // Protected by hash mutex.
-    bool pending_;
-    bool partitioned_;
+    bool rejected_;
     hash_heights heights_;
+    std::chrono::high_resolution_clock::time_point progress_;
     mutable upgrade_mutex hash_mutex_;
 
     // Thread safe.
+    std::atomic<bool> retired_;
     reservations& reservations_;
     const size_t slot_;
+    const size_t window_;
     const std::chrono::microseconds rate_window_;
 };
 
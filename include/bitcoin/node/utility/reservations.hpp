@@ -22,13 +22,19 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <vector>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/settings.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
+#include <bitcoin/node/utility/import_queue.hpp>
+#include <bitcoin/node/utility/performance.hpp>
+#include <bitcoin/node/utility/reorder_buffer.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
+#include <bitcoin/node/utility/size_profile.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -42,35 +48,103 @@ public:
         size_t active_count;
         double arithmentic_mean;
         double standard_deviation;
+        double throughput;
+        double database_ratio;
     } rate_statistics;
 
+    /// Store commit bounds for the length of block sync.
+    typedef struct
+    {
+        size_t batch_blocks;
+        size_t reorder_bytes;
+    } durability;
+
     typedef std::shared_ptr<reservations> ptr;
 
+    /// The relaxed or strict durability profile selected by the settings.
+    static const durability& sync_durability(const settings& settings);
+
     /// Construct a reservation table of reservations, allocating hashes evenly
-    /// among the rows up to the limit of a single get headers p2p request.
-    reservations(check_list& hashes, blockchain::fast_chain& chain,
+    /// by expected bytes among the rows, up to the limit of a single get
+    /// headers p2p request per row.
+    reservations(check_list& hashes, height_bitmap& populated,
+        size_profile& sizes, blockchain::fast_chain& chain,
         const settings& settings);
 
-    /// Set the flush lock guard.
+    /// Construct a reservation table with the specified store commit bounds
+    /// in place of the profile selected by the settings, which must outlive
+    /// the table.
+    reservations(check_list& hashes, height_bitmap& populated,
+        size_profile& sizes, blockchain::fast_chain& chain,
+        const settings& settings, const durability& durability);
+
+    /// Set the flush lock guard and start the store thread.
     bool start();
 
-    /// Clear the flush lock guard.
+    /// Store all queued blocks and clear the flush lock guard, leaving the
+    /// store fully flushed. False if any block failed to store.
     bool stop();
 
+    /// A block failed to store, so sync cannot complete.
+    bool failed() const;
+
     /// The average and standard deviation of block import rates.
     rate_statistics rates() const;
 
+    /// Replace the contribution of a row rate to the rate statistics.
+    void update_rates(const performance& prior, const performance& next);
+
     /// Return a copy of the reservation table.
     reservation::list table() const;
 
-    /// Import the given block to the blockchain at the specified height.
+    /// Import the given block to the blockchain at the specified height,
+    /// marking the height populated once stored.
+    /// A sequential store buffers the block until it can commit in order.
     bool import(block_const_ptr block, size_t height);
 
+    /// The highest block height that may currently be requested.
+    size_t request_ceiling() const;
+
+    /// Queue the block of the row for context free checks on a worker, and
+    /// then for storage if valid, otherwise return its hash to the table.
+    void check(reservation::ptr row, block_const_ptr block, size_t height);
+
+    /// No block awaits checks and no hash is left unreserved.
+    bool drained() const;
+
+    /// Queue the block of the row for storage on the store thread.
+    void enqueue(reservation::ptr row, block_const_ptr block, size_t height);
+
+    /// The check or store queue is full, so block requests should pause.
+    bool backlogged() const;
+
+    /// The expected block sizes used to allocate hashes to rows.
+    const size_profile& profile() const;
+
     /// Populate a starved row by taking half of the hashes from a weak row.
     bool populate(reservation::ptr minimal);
 
     /// Remove the row from the reservation table if found.
-    void remove(reservation::ptr row);
+    /// Return true if this removal emptied the table and it is drained.
+    bool remove(reservation::ptr row);
+
+    /// Add a populated row if below the configured maximum, or return null.
+    reservation::ptr expand();
+
+    /// Retire the slowest active row, moving its unrequested hashes to the
+    /// live rows. The row completes once its blocks in flight arrive.
+    bool contract();
+
+    /// Request the lowest outstanding blocks of stalled rows again from the
+    /// fastest active rows, and move the next commit height of a saturated
+    /// reorder buffer to a live row, returning the number of blocks moved.
+    size_t rescue();
+
+    /// Resolve a block received by the row that may also have been requested
+    /// from another row, discarding the other request. Return false if the
+    /// block was already received by the other row.
+    bool resolve(reservation::ptr row, const hash_digest& hash,
+        size_t height);
 
     /// The max size of a block request.
     size_t max_request() const;
@@ -81,29 +155,106 @@ public:
 private:
     bool inline flush(size_t height);
 
+#if defined(BITPRIM_DB_LEGACY)
+    // Cycle the flush lock guard once a batch of blocks has been inserted.
+    bool checkpoint();
+#endif
+
+#if defined(BITPRIM_DB_NEW)
+    // Insert buffered blocks to the store while the next height is present.
+    bool commit();
+
+    // Move the unreserved next commit height to a live row if saturated.
+    bool unblock();
+#endif
+
     // Create the specified number of reservations and distribute hashes.
     void initialize(size_t connections);
 
-    // Find the reservation with the most hashes.
+    // Find the reservation with the most unrequested hashes.
     reservation::ptr find_maximal();
 
+    // Find the active reservation with the lowest normal rate.
+    reservation::ptr find_slowest();
+
+    // Find the reservations that are neither retired nor empty.
+    reservation::list find_live() const;
+
+    // Spread the hashes over the live reservations.
+    void reassign(const hash_heights& hashes);
+
+    // Drop the duplicate entries of the retired row whose copy it returned.
+    void forget(reservation::ptr row, hash_heights& returned);
+
+    // Drop the duplicate entries of the removed row.
+    void forget(reservation::ptr row);
+
+    // Flag the rejection to the row and return the hash to the table.
+    void reject(reservation::ptr row, block_const_ptr block, size_t height,
+        const code& ec);
+
     // Move half of the maximal reservation to the specified reservation.
     bool partition(reservation::ptr minimal);
 
-    // Move the maximum unreserved hashes to the specified reservation.
+    // Move unreserved hashes up to the byte budget to the reservation.
     bool reserve(reservation::ptr minimal);
 
+    struct duplicate
+    {
+        reservation::ptr holder;
+        reservation::ptr thief;
+        hash_digest hash;
+        bool received;
+    };
+
     // Thread safe.
     check_list& hashes_;
+    height_bitmap& populated_;
+    size_profile& profile_;
     std::atomic<size_t> max_request_;
+    std::atomic<bool> failed_;
+    std::atomic<size_t> checking_;
     const uint32_t timeout_;
+    const size_t window_;
+    const size_t maximum_rows_;
+    const durability& durability_;
 
     // Protected by block exclusivity and limited call scope.
     blockchain::fast_chain& chain_;
 
+#if defined(BITPRIM_DB_LEGACY)
+    // Protected by commit mutex, shared by inserts, unique for the cycle.
+    size_t inserted_;
+    mutable upgrade_mutex commit_mutex_;
+#elif defined(BITPRIM_DB_NEW)
+    // Thread safe, commits serialized by commit mutex.
+    reorder_buffer buffer_;
+    mutable upgrade_mutex commit_mutex_;
+#endif
+
+    // Read through a sequence lock, odd while a summary update is stored.
+    // Updates are serialized by the rates mutex, which readers never take.
+    std::atomic<uint32_t> rates_sequence_;
+    std::atomic<size_t> active_rows_;
+    std::atomic<double> rate_sum_;
+    std::atomic<double> rate_squares_;
+    std::atomic<double> throughput_;
+    std::atomic<double> ratio_sum_;
+    mutable upgrade_mutex rates_mutex_;
+
+    // Protected by duplicates mutex, keyed by height.
+    std::map<size_t, duplicate> duplicates_;
+    mutable upgrade_mutex duplicates_mutex_;
+
     // Protected by mutex.
     reservation::list table_;
+    size_t next_slot_;
     mutable upgrade_mutex mutex_;
+
+    // Thread safe, declared last so that queued jobs drain before the state
+    // they use is destroyed, and checks drain first as they feed the store.
+    import_queue queue_;
+    import_queue checks_;
 };
 
 } // namespace node
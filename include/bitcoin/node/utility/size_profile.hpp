@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_SIZE_PROFILE_HPP
+#define LIBBITCOIN_NODE_SIZE_PROFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// An estimate of serialized block size by height, thread safe.
+/// A compact shipped mainnet profile is refined by the sizes of stored
+/// blocks, which are persisted so that they survive a restart.
+class BCN_API size_profile
+{
+public:
+    /// The number of heights summarized by each learned interval.
+    static const size_t interval;
+
+    /// Construct an unpersisted profile from the shipped estimates alone.
+    size_profile();
+
+    /// Construct a profile persisted to the file. The shipped estimates are
+    /// of mainnet, so another network uses a flat estimate until learned.
+    size_profile(const boost::filesystem::path& file, bool mainnet);
+
+    /// Read the learned sizes from the file, false if missing or invalid.
+    bool load();
+
+    /// Write the learned sizes to the file.
+    bool save() const;
+
+    /// The expected serialized size of the block at the height.
+    uint64_t estimate(size_t height) const;
+
+    /// Learn the serialized size of the block stored at the height.
+    void record(size_t height, size_t bytes);
+
+    /// The shipped estimate of the size of the block at the height.
+    static uint64_t shipped(size_t height);
+
+private:
+    typedef struct
+    {
+        uint64_t bytes;
+        uint32_t blocks;
+    } summary;
+
+    // Thread safe.
+    const boost::filesystem::path file_;
+    const bool mainnet_;
+
+    // Protected by mutex.
+    std::vector<summary> learned_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
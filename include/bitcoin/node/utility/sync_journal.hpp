@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_SYNC_JOURNAL_HPP
+#define LIBBITCOIN_NODE_SYNC_JOURNAL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A file of the block heights and header hashes that remain to be synced,
+/// so that a restarted sync resumes without a database gap scan, thread safe.
+/// The heights stored since the file was written are appended to a log file,
+/// and the file is rewritten once compacted. Entries stored after the last
+/// save are excluded when loaded.
+class BCN_API sync_journal
+{
+public:
+    /// Construct a journal of the file, validated against the checkpoint.
+    /// Stored entries are found in the bitmap of populated heights if valid.
+    sync_journal(const boost::filesystem::path& file,
+        const config::checkpoint& last, const height_bitmap& populated);
+
+    /// The entries were captured from a complete header sync.
+    bool captured() const;
+
+    /// Reserve the unstored journal entries in the hash list, false if
+    /// there is no valid journal.
+    bool load(check_list& hashes, blockchain::fast_chain& chain);
+
+    /// Retain the entries of the hash list as the sync state.
+    void capture(const check_list& hashes);
+
+    /// Log the heights of retained entries stored since the last save.
+    /// The unstored entries are written in place of the log once captured,
+    /// if compacting, or once the log outgrows them, removing both if none.
+    bool save(blockchain::fast_chain& chain, bool compact=false);
+
+    /// Drop the retained entries and remove the file and its log.
+    bool clear();
+
+private:
+    typedef std::vector<size_t> heights;
+
+    // Remove entries of blocks that are already stored, appending their
+    // heights to out.
+    void prune(blockchain::fast_chain& chain, heights& out_stored);
+
+    // Remove entries of the heights read from the log, false if invalid.
+    bool replay();
+
+    // Write the entries to the file, replacing it by rename, and then
+    // remove the log.
+    bool write(const config::checkpoint::list& entries) const;
+
+    // Append the stored heights to the log.
+    bool append(const heights& stored) const;
+
+    // Thread safe.
+    const boost::filesystem::path file_;
+    const boost::filesystem::path log_;
+    const config::checkpoint last_;
+    const height_bitmap& populated_;
+
+    // Protected by file mutex, which orders saves and clears.
+    mutable upgrade_mutex file_mutex_;
+
+    // These are protected by mutex.
+    bool captured_;
+    bool written_;
+    size_t logged_;
+    config::checkpoint::list entries_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
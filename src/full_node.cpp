@@ -18,9 +18,12 @@
  */
 #include <bitcoin/node/full_node.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <thread>
 #include <utility>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/node/configuration.hpp>
@@ -40,10 +43,64 @@ using namespace bc::config;
 using namespace bc::network;
 using namespace std::placeholders;
 
+// The sync journal file name, in the database directory.
+static const auto journal_file = "sync_journal";
+
+// The populated height bitmap file name, in the database directory.
+static const auto bitmap_file = "height_bitmap";
+
+// The learned block size profile file name, in the database directory.
+static const auto profile_file = "size_profile";
+
+// Announced headers are retained to this depth below the chain top, up to a
+// total count and a count added by any one peer (several header messages).
+static constexpr size_t header_tree_depth = 1000;
+static constexpr size_t header_tree_maximum = 100000;
+static constexpr size_t header_tree_peer_maximum = 10000;
+
+// The blocks in flight from one peer, and the time after which another peer
+// that announced a block may request it again.
+static constexpr size_t peer_requests = 16;
+static const std::chrono::seconds request_timeout(20);
+
+// The batches of prevout lookups queued before further prefetches are dropped.
+static constexpr size_t prefetch_capacity = 256;
+
+// Prevout lookups are store reads, spread across all cores.
+static size_t prefetch_threads()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// The shipped block size profile describes mainnet, as does the genesis block
+// selected by these settings (see get_genesis_block). Only mainnet bounds the
+// target step between headers, as easy blocks may drop to the limit.
+static bool is_mainnet(const blockchain::settings& settings)
+{
+    return settings.retarget && !settings.easy_blocks;
+}
+
+// The journal is bound to the highest checkpoint, the end of checked sync.
+static checkpoint last_checkpoint(const checkpoint::list& checkpoints)
+{
+    const auto sorted = checkpoint::sort(checkpoints);
+    return sorted.empty() ? checkpoint{} : sorted.back();
+}
+
 full_node::full_node(const configuration& configuration)
     : multi_crypto_setter(configuration.network)
     , p2p(configuration.network)
     , chain_(thread_pool(), configuration.chain, configuration.database, configuration.network.relay_transactions)
+    , populated_(configuration.database.directory / bitmap_file)
+    , journal_(configuration.database.directory / journal_file,
+        last_checkpoint(configuration.chain.checkpoints), populated_)
+    , sizes_(configuration.database.directory / profile_file,
+        is_mainnet(configuration.chain))
+    , headers_(header_tree_depth, header_tree_maximum,
+        header_tree_peer_maximum, is_mainnet(configuration.chain))
+    , requests_(peer_requests, request_timeout)
+    , prevouts_(std::bind(&full_node::prefetch_output, this, _1),
+        prefetch_capacity, prefetch_threads())
     , protocol_maximum_(configuration.network.protocol_maximum)
     , chain_settings_(configuration.chain)
     , node_settings_(configuration.node)
@@ -93,53 +150,73 @@ void full_node::run(result_handler handler)
         return;
     }
 
-    // Skip sync sessions.
-    handle_running(error::success, handler);
-    return;
-
-    // TODO: make this safe by requiring sync if gaps found.
-    ////// By setting no download connections checkpoints can be used without sync.
-    ////// This also allows the maximum protocol version to be set below headers.
-    ////if (settings_.sync_peers == 0)
-    ////{
-    ////    // This will spawn a new thread before returning.
-    ////    handle_running(error::success, handler);
-    ////    return;
-    ////}
-
-    ////// The instance is retained by the stop handler (i.e. until shutdown).
-    ////const auto header_sync = attach_header_sync_session();
-
-    ////// This is invoked on a new thread.
-    ////header_sync->start(
-    ////    std::bind(&full_node::handle_headers_synchronized,
-    ////        this, _1, handler));
+    // The bitmap is valid only if saved at the current top on a clean stop.
+    size_t top;
+    if (chain_.get_last_height(top) && populated_.load(top))
+        LOG_INFO(LOG_NODE)
+            << "Loaded bitmap of " << populated_.count()
+            << " populated heights.";
+
+    // Sizes learned from previously stored blocks refine sync allocation.
+    if (sizes_.load())
+        LOG_INFO(LOG_NODE)
+            << "Loaded learned block size profile.";
+
+    // By setting no download connections checkpoints can be used without sync.
+    // This also allows the maximum protocol version to be set below headers.
+    if (node_settings_.sync_peers == 0)
+    {
+        // This will spawn a new thread before returning.
+        handle_running(error::success, handler);
+        return;
+    }
+
+    // An interrupted sync resumes from its journal without a gap scan.
+    if (journal_.load(hashes_, chain_))
+        LOG_INFO(LOG_NODE)
+            << "Loaded sync journal of " << hashes_.size() << " blocks.";
+
+    // The instance is retained by the stop handler (i.e. until shutdown).
+    const auto header_sync = attach_header_sync_session();
+
+    // This is invoked on a new thread.
+    header_sync->start(
+        std::bind(&full_node::handle_headers_synchronized,
+            this, _1, handler));
 }
 
 void full_node::handle_headers_synchronized(const code& ec,
     result_handler handler)
 {
-    ////if (stopped())
-    ////{
-    ////    handler(error::service_stopped);
-    ////    return;
-    ////}
-
-    ////if (ec)
-    ////{
-    ////    LOG_ERROR(LOG_NODE)
-    ////        << "Failure synchronizing headers: " << ec.message();
-    ////    handler(ec);
-    ////    return;
-    ////}
-
-    ////// The instance is retained by the stop handler (i.e. until shutdown).
-    ////const auto block_sync = attach_block_sync_session();
-
-    ////// This is invoked on a new thread.
-    ////block_sync->start(
-    ////    std::bind(&full_node::handle_running,
-    ////        this, _1, handler));
+    if (stopped())
+    {
+        handler(error::service_stopped);
+        return;
+    }
+
+    if (ec)
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Failure synchronizing headers: " << ec.message();
+        handler(ec);
+        return;
+    }
+
+    // Block sync takes hashes from the list, so the journal retains them.
+    journal_.capture(hashes_);
+
+    if (!journal_.save(chain_))
+        LOG_ERROR(LOG_NODE)
+            << "Failed to save sync journal.";
+
+    // The instance is retained by the stop handler (i.e. until shutdown).
+    const auto block_sync = attach_block_sync_session();
+
+    // This is invoked on a new thread.
+    // Long running sessions start in handle_running once blocks are synced.
+    block_sync->start(
+        std::bind(&full_node::handle_running,
+            this, _1, handler));
 }
 
 void full_node::handle_running(const code& ec, result_handler handler) {
@@ -165,6 +242,15 @@ void full_node::handle_running(const code& ec, result_handler handler) {
         return;
     }
 
+    // Announced headers are linked to the chain from its top.
+    headers_.anchor(top_hash, top_height);
+
+    if (!locator_.rebuild(chain_))
+        LOG_ERROR(LOG_NODE)
+            << "Failed to build block locator.";
+
+    prevouts_.start();
+
     set_top_block({ std::move(top_hash), top_height });
 
     LOG_INFO(LOG_NODE) << "Node start height is (" << top_height << ").";
@@ -198,12 +284,31 @@ bool full_node::handle_reorganized(code ec, size_t fork_height,
         return true;
 
     for (const auto block: *outgoing)
+    {
+        headers_.disconnect(block->hash());
         LOG_DEBUG(LOG_NODE)
             << "Reorganization moved block to orphan pool ["
             << encode_hash(block->header().hash()) << "]";
+    }
 
     const auto height = safe_add(fork_height, incoming->size());
 
+    // Outgoing heights are emptied unless refilled by the incoming blocks.
+    for (auto index = incoming->size(); index < outgoing->size(); ++index)
+        populated_.reset(fork_height + index + 1u);
+
+    for (size_t index = 0; index < incoming->size(); ++index)
+    {
+        const auto connected = fork_height + index + 1u;
+        populated_.set(connected);
+        headers_.connect((*incoming)[index]->header(), connected);
+    }
+
+    // The locator is rebuilt from the store at the new top.
+    if (!locator_.rebuild(chain_))
+        LOG_ERROR(LOG_NODE)
+            << "Failed to rebuild block locator.";
+
     set_top_block({ incoming->back()->hash(), height });
     return true;
 }
@@ -231,13 +336,14 @@ network::session_outbound::ptr full_node::attach_outbound_session()
 
 session_header_sync::ptr full_node::attach_header_sync_session()
 {
-    return attach<session_header_sync>(hashes_, chain_,
-        chain_.chain_settings().checkpoints);
+    return attach<session_header_sync>(hashes_, populated_, chain_,
+        chain_.chain_settings().checkpoints, node_settings_);
 }
 
 session_block_sync::ptr full_node::attach_block_sync_session()
 {
-    return attach<session_block_sync>(hashes_, chain_, node_settings_);
+    return attach<session_block_sync>(hashes_, journal_, populated_, sizes_,
+        chain_, node_settings_);
 }
 
 // Shutdown
@@ -247,17 +353,51 @@ bool full_node::stop()
 {
     // Suspend new work last so we can use work to clear subscribers.
     const auto p2p_stop = p2p::stop();
+
+    // During header sync the hash list is the sync state. An empty list
+    // without captured state means no sync is in progress.
+    if (!journal_.captured() && !hashes_.empty())
+        journal_.capture(hashes_);
+
+    // Lookups read the store, so they complete before chain stop.
+    prevouts_.stop();
+
+    // The journal excludes stored blocks, so it is saved before chain stop,
+    // compacting its log of stored heights.
+    const auto journal_save = !journal_.captured() ||
+        journal_.save(chain_, true);
+
+    // A later store removes the bitmap file, so it is rebuilt on restart.
+    size_t top;
+    const auto bitmap_save = !populated_.valid() ||
+        (chain_.get_last_height(top) && populated_.save(top));
     const auto chain_stop = chain_.stop();
 
+    // Sizes are only learned during block sync, which is stopped by now.
+    const auto profile_save = sizes_.save();
+
     if (!p2p_stop)
         LOG_ERROR(LOG_NODE)
             << "Failed to stop network.";
 
+    if (!journal_save)
+        LOG_ERROR(LOG_NODE)
+            << "Failed to save sync journal.";
+
+    if (!bitmap_save)
+        LOG_ERROR(LOG_NODE)
+            << "Failed to save populated height bitmap.";
+
+    if (!profile_save)
+        LOG_ERROR(LOG_NODE)
+            << "Failed to save learned block size profile.";
+
     if (!chain_stop)
         LOG_ERROR(LOG_NODE)
             << "Failed to stop blockchain.";
 
-    return p2p_stop && chain_stop;
+    return p2p_stop && journal_save && bitmap_save && profile_save &&
+        chain_stop;
 }
 
 // This must be called from the thread that constructed this class (see join).
@@ -302,6 +442,45 @@ safe_chain& full_node::chain()
     return chain_;
 }
 
+header_tree& full_node::headers()
+{
+    return headers_;
+}
+
+block_requests& full_node::requests()
+{
+    return requests_;
+}
+
+locator_cache& full_node::locator()
+{
+    return locator_;
+}
+
+prevout_prefetch& full_node::prevouts()
+{
+    return prevouts_;
+}
+
+// Reading a prevout brings its store pages into memory ahead of validation,
+// which populates the same outputs. The result is not used.
+void full_node::prefetch_output(const output_point& point) const
+{
+#if defined(BITPRIM_DB_LEGACY)
+    output prevout;
+    size_t height;
+    uint32_t median_time_past;
+    bool coinbase;
+
+    chain_.get_output(prevout, height, median_time_past, coinbase, point,
+        max_size_t, false);
+#elif defined(BITPRIM_DB_NEW)
+    chain_.get_utxo(point, max_size_t);
+#else
+#error You must define BITPRIM_DB_LEGACY or BITPRIM_DB_NEW
+#endif
+}
+
 //TODO: remove this function and use safe_chain in the rpc lib
 block_chain& full_node::chain_bitprim()
 {
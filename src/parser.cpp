@@ -544,16 +544,26 @@ options_metadata parser::load_settings()
 
 
     /* [node] */
-    ////(
-    ////    "node.sync_peers",
-    ////    value<uint32_t>(&configured.node.sync_peers),
-    ////    "The maximum number of initial block download peers, defaults to 0 (physical cores)."
-    ////)
-    ////(
-    ////    "node.sync_timeout_seconds",
-    ////    value<uint32_t>(&configured.node.sync_timeout_seconds),
-    ////    "The time limit for block response during initial block download, defaults to 5."
-    ////)
+    (
+        "node.sync_peers",
+        value<uint32_t>(&configured.node.sync_peers),
+        "The maximum number of initial block download peers, defaults to 0 (disables headers-first sync)."
+    )
+    (
+        "node.sync_timeout_seconds",
+        value<uint32_t>(&configured.node.sync_timeout_seconds),
+        "The time limit for block response during initial block download, defaults to 5."
+    )
+    (
+        "node.sync_window",
+        value<uint32_t>(&configured.node.sync_window),
+        "The maximum number of blocks in flight to each initial block download peer, defaults to 64."
+    )
+    (
+        "node.sync_relaxed",
+        value<bool>(&configured.node.sync_relaxed),
+        "Commit initial block download in large batches, flushing the store at completion, defaults to true."
+    )
     (
         "node.block_latency_seconds",
         value<uint32_t>(&configured.node.block_latency_seconds),
@@ -31,6 +31,8 @@
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/full_node.hpp>
+#include <bitcoin/node/utility/hash_batch.hpp>
+#include <bitcoin/node/utility/header_tree.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -141,6 +143,14 @@ void protocol_block_in::start()
 //-----------------------------------------------------------------------------
 
 void protocol_block_in::send_get_blocks(const hash_digest& stop_hash) {
+    // The node maintains the locator of its top, so the store is not read.
+    auto const hashes = node_.locator().hashes();
+
+    if ( ! hashes.empty()) {
+        handle_fetch_block_locator(error::success, std::make_shared<get_headers>(hashes, stop_hash), stop_hash);
+        return;
+    }
+
     auto const heights = block::locator_heights(node_.top_block().height());
     chain_.fetch_block_locator(heights, BIND3(handle_fetch_block_locator, _1, _2, stop_hash));
 }
@@ -210,19 +220,36 @@ bool protocol_block_in::handle_receive_headers(code const& ec, headers_const_ptr
         return false;
     }
 
-    // There is no benefit to this use of headers, in fact it is suboptimal.
-    // In v3 headers will be used to build block tree before getting blocks.
+    // Headers build the node-wide tree before any block is requested.
+    hash_list fetch;
+    auto const result = node_.headers().add(nonce(), message->elements(), fetch);
+
+    if (result == header_tree::status::invalid) {
+        LOG_WARNING(LOG_NODE) << "Block headers with invalid proof of work from [" << authority() << "].";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    if (result == header_tree::status::saturated) {
+        LOG_WARNING(LOG_NODE) << "Block headers over the announcement limit from [" << authority() << "].";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    auto const type = compact_from_peer_ ? inventory::type_id::compact_block : inventory::type_id::block;
     auto const response = std::make_shared<get_data>();
 
-    if (compact_from_peer_) {
-        // LOG_INFO(LOG_NODE) << " protocol_block_in::handle_receive_headers (compactblock) [" << authority() << "] ";
-        message->to_inventory(response->inventories(), inventory::type_id::compact_block);
+    if (result == header_tree::status::orphan) {
+        // An unlinked announcement is requested as is, so that the orphan
+        // block causes the missing headers to be requested.
+        message->to_inventory(response->inventories(), type);
     } else {
-        // LOG_INFO(LOG_NODE) << " protocol_block_in::handle_receive_headers (block) [" << authority() << "] ";
-        message->to_inventory(response->inventories(), inventory::type_id::block);
+        // Only blocks of a branch with more work than the chain are fetched.
+        for (auto const& hash: fetch) {
+            response->inventories().emplace_back(type, hash);
+        }
     }
-   
-    // asm("int $3");  //TODO(fernando): remover
+
     // Remove hashes of blocks that we already have.
     chain_.filter_blocks(response, BIND2(send_get_data, _1, response));
     return true;
@@ -268,6 +295,31 @@ void protocol_block_in::send_get_data(const code& ec, get_data_ptr message)
     if (message->inventories().empty())
         return;
 
+    // Each block is requested from one peer at a time across the node.
+    hash_list hashes;
+    hash_list claimed;
+
+    for (auto const& inventory: message->inventories()) {
+        hashes.push_back(inventory.hash());
+    }
+
+    node_.requests().claim(nonce(), hashes, claimed);
+
+    // The claimed hashes are in inventory order.
+    size_t next = 0;
+    auto& inventories = message->inventories();
+    auto const unclaimed = [&](inventory_vector const& inventory) {
+        if (next < claimed.size() && inventory.hash() == claimed[next]) {
+            ++next;
+            return false;
+        }
+        return true;
+    };
+
+    inventories.erase(std::remove_if(inventories.begin(), inventories.end(), unclaimed), inventories.end());
+
+    if (inventories.empty())
+        return;
 
     if (compact_from_peer_) {
 
@@ -289,16 +341,17 @@ void protocol_block_in::send_get_data(const code& ec, get_data_ptr message)
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     mutex.lock_upgrade();
-    auto const fresh = backlog_.empty();
+    auto const fresh = requested_.empty();
     mutex.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-    // Enqueue the block inventory behind the preceding block inventory.
+    // Record the request time of each block, renewed if requested again.
+    auto const now = asio::steady_clock::now();
+
     for (auto const& inventory: message->inventories()){
-        if (inventory.type() == inventory::type_id::block) {
-            backlog_.push(inventory.hash());
-        } else if (inventory.type() == inventory::type_id::compact_block) {
-            backlog_.push(inventory.hash());
+        if (inventory.type() == inventory::type_id::block ||
+            inventory.type() == inventory::type_id::compact_block) {
+            requested_[inventory.hash()] = now;
         }
     }
 
@@ -361,10 +414,18 @@ bool protocol_block_in::handle_receive_not_found(const code& ec,
 //-----------------------------------------------------------------------------
 
 void protocol_block_in::organize_block(block_const_ptr message) {
+    node_.requests().complete(nonce(), message->hash());
     message->validation.originator = nonce();
     chain_.organize(message, BIND2(handle_store_block, _1, message));
 }
 
+// A received block that is not organized no longer holds its flight, which
+// frees the slot for blocks this peer waits on.
+void protocol_block_in::skip_block(const hash_digest& hash) {
+    node_.requests().complete(nonce(), hash);
+    reclaim_blocks();
+}
+
 bool protocol_block_in::handle_receive_block(const code& ec,
     block_const_ptr message)
 {
@@ -375,30 +436,22 @@ bool protocol_block_in::handle_receive_block(const code& ec,
     // Critical Section
     mutex.lock();
 
-    auto matched = !backlog_.empty() && backlog_.front() == message->hash();
+    // Requests are interleaved across threads, so blocks of any requested
+    // hash are accepted in any order.
+    auto const matched = requested_.erase(message->hash()) != 0;
 
-    if (matched)
-        backlog_.pop();
-
-    // Empty after pop means we need to make a new request.
-    auto const cleared = backlog_.empty();
+    // Empty after erase means we need to make a new request.
+    auto const cleared = requested_.empty();
 
     mutex.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
-    // If a peer sends a block unannounced we drop the peer - always. However
-    // it is common for block announcements to cause block requests to be sent
-    // out of backlog order due to interleaving of threads. This results in
-    // channel drops during initial block download but not after sync. The
-    // resolution to this issue is use of headers-first sync, but short of that
-    // the current implementation performs well and drops peers no more
-    // frequently than block announcements occur during initial block download,
-    // and not typically after it is complete.
+    // If a peer sends a block unrequested we drop the peer - always.
     if (!matched)
     {
         LOG_DEBUG(LOG_NODE)
             << "Block [" << encode_hash(message->hash())
-            << "] unexpected or out of order from [" << authority() << "]";
+            << "] unrequested from [" << authority() << "]";
         stop(error::channel_stopped);
         return false;
     }
@@ -424,9 +477,27 @@ bool protocol_block_in::handle_receive_block(const code& ec,
     if (cleared)
         send_get_blocks(null_hash);
 
+    reclaim_blocks();
     return true;
 }
 
+// Request blocks announced by this peer that others released or timed out.
+void protocol_block_in::reclaim_blocks() {
+    hash_list reclaimed;
+    node_.requests().reclaim(nonce(), reclaimed);
+
+    if (reclaimed.empty()) {
+        return;
+    }
+
+    LOG_DEBUG(LOG_NODE)
+        << "Reclaimed " << reclaimed.size() << " blocks in flight for ["
+        << authority() << "]";
+
+    auto const type = compact_from_peer_ ? inventory::type_id::compact_block : inventory::type_id::block;
+    send_get_data(error::success, std::make_shared<get_data>(reclaimed, type));
+}
+
 bool protocol_block_in::handle_receive_block_transactions(const code& ec, block_transactions_const_ptr message)
 {
     if (stopped(ec))
@@ -446,6 +517,9 @@ bool protocol_block_in::handle_receive_block_transactions(const code& ec, block_
 
     auto const& vtx_missing = message->transactions();
 
+    // The prevouts of the other transactions were prefetched on the compact block.
+    node_.prevouts().prefetch(vtx_missing);
+
     auto& txn_available = temp_compact_block_.transactions;
     auto const& header_temp = temp_compact_block_.header;
 
@@ -482,6 +556,17 @@ bool protocol_block_in::handle_receive_block_transactions(const code& ec, block_
         return false;
     }
 
+    if ( ! is_reconstructed(header_temp, txn_available)) {
+        LOG_DEBUG(LOG_NODE)
+            << "Compact Block [" << encode_hash(message->block_hash())
+            << "] The reconstructed merkle root is invalid, requesting the full block [" << authority() << "]";
+
+        //TODO(Mario) verify if necesary mutual exclusion
+        compact_blocks_map_.erase(it);
+        send_get_data_compact_block(ec, message->block_hash());
+        return true;
+    }
+
     auto const tempblock = std::make_shared<message::block>(std::move(header_temp), std::move(txn_available));
         
     organize_block(tempblock);
@@ -539,11 +624,50 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
         return false;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex.lock();
+
+    // A compact block answers its request, and in high bandwidth mode may
+    // also arrive unrequested.
+    requested_.erase(header_temp.hash());
+
+    mutex.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
     //if the compact block exists in the map, is already in process
     if (compact_blocks_map_.count(header_temp.hash()) > 0) {
         return true;
     }
 
+    // The header feeds the node-wide tree, so a low work block is skipped.
+    hash_list fetch;
+    auto const result = node_.headers().add(nonce(), { header_temp }, fetch);
+
+    if (result == header_tree::status::invalid) {
+        LOG_DEBUG(LOG_NODE)
+            << "Compact Block [" << encode_hash(header_temp.hash())
+            << "] The compact block proof of work is invalid [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    if (result == header_tree::status::saturated) {
+        LOG_DEBUG(LOG_NODE)
+            << "Compact Block [" << encode_hash(header_temp.hash())
+            << "] is over the announcement limit [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    if (result == header_tree::status::accepted && fetch.empty()) {
+        LOG_DEBUG(LOG_NODE)
+            << "Compact Block [" << encode_hash(header_temp.hash())
+            << "] is not on the most work branch [" << authority() << "]";
+        skip_block(header_temp.hash());
+        return true;
+    }
+
     //LOG_INFO(LOG_NODE) << "asm int $3 - 0";
     //asm("int $3");  //TODO(fernando): remover
             
@@ -560,9 +684,18 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
             LOG_DEBUG(LOG_NODE)
             << "The chain isn't stale sending getheaders message [" << authority() << "]";
             
-            auto const heights = block::locator_heights(node_.top_block().height());
-            chain_.fetch_block_locator(heights,BIND3(handle_fetch_block_locator_compact_block, _1, _2, null_hash));
+            auto const hashes = node_.locator().hashes();
+
+            if ( ! hashes.empty()) {
+                handle_fetch_block_locator_compact_block(error::success, std::make_shared<get_headers>(hashes, null_hash), null_hash);
+            } else {
+                auto const heights = block::locator_heights(node_.top_block().height());
+                chain_.fetch_block_locator(heights,BIND3(handle_fetch_block_locator_compact_block, _1, _2, null_hash));
+            }
         } 
+
+        // The block is fetched again once its parent header is linked.
+        skip_block(header_temp.hash());
         return true;
     }
     //  else {
@@ -688,7 +821,21 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
         }
     }
 
+    // Prevouts of the known transactions are read in parallel, while any
+    // missing transactions are requested and before the block is organized.
+    node_.prevouts().prefetch(txs_available);
+
     if (txs.empty()) {
+        // A short id collision with the mempool substitutes the wrong
+        // transaction, which is caught by the merkle root of the header.
+        if ( ! is_reconstructed(header_temp, txs_available)) {
+            LOG_DEBUG(LOG_NODE)
+                << "Compact Block [" << encode_hash(header_temp.hash())
+                << "] The reconstructed merkle root is invalid, requesting the full block [" << authority() << "]";
+            send_get_data_compact_block(ec, header_temp.hash());
+            return true;
+        }
+
         auto const tempblock = std::make_shared<message::block>(std::move(header_temp), std::move(txs_available)); 
         organize_block(tempblock);
         return true;
@@ -700,6 +847,14 @@ bool protocol_block_in::handle_receive_compact_block(code const& ec, compact_blo
     } 
 }
 
+// The txids are hashed as one batch, as is each level of the merkle tree.
+bool protocol_block_in::is_reconstructed(const chain::header& header,
+    const chain::transaction::list& transactions) const
+{
+    static const hash_batch hasher;
+    return hasher.merkle_root(hasher.hash(transactions)) == header.merkle();
+}
+
 void protocol_block_in::send_get_data_compact_block(const code& ec, const hash_digest& hash) {
 
     hash_list hashes;
@@ -791,27 +946,47 @@ void protocol_block_in::handle_timeout(const code& ec)
         return;
     }
 
+    auto const now = asio::steady_clock::now();
+    auto const late = [&](request_map::value_type const& request) {
+        return now - request.second >= block_latency_;
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     mutex.lock_shared();
-    auto const backlog_empty = backlog_.empty();
+    auto const pending = !requested_.empty();
+    auto const expired = std::any_of(requested_.begin(), requested_.end(), late);
     mutex.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
 
-    // Can only end up here if time was not extended.
-    if (!backlog_empty)
+    // Only a block outstanding for the full latency fails the peer.
+    if (expired)
     {
         LOG_DEBUG(LOG_NODE)
             << "Peer [" << authority()
             << "] exceeded configured block latency.";
         stop(ec);
+        return;
+    }
+
+    // Later requests are still within latency, so check them again.
+    if (pending)
+    {
+        reset_timer();
+        return;
     }
 
     // Can only end up here if peer did not respond to inventory or get_data.
     // At this point we are caught up with an honest peer. But if we are stale
     // we should try another peer and not just keep pounding this one.
     if (chain_.is_stale())
+    {
         stop(error::channel_stopped);
+        return;
+    }
+
+    // Blocks that other peers failed to deliver are requested from this one.
+    reclaim_blocks();
 
     // If we are not stale then we are either good or stalled until peer sends
     // an announcement. There is no sense pinging a broken peer, so we either
@@ -824,6 +999,9 @@ void protocol_block_in::handle_timeout(const code& ec)
 
 void protocol_block_in::handle_stop(const code&)
 {
+    node_.headers().remove(nonce());
+    node_.requests().release(nonce());
+
     LOG_DEBUG(LOG_NETWORK)
         << "Stopped block_in protocol for [" << authority() << "].";
 }
@@ -85,7 +85,7 @@ void protocol_block_sync::send_get_blocks(event_handler complete, bool reset)
     // We may be a new channel (reset) or may have a new packet.
     const auto request = reservation_->request(reset);
 
-    // Or we may be the same channel and with hashes already requested.
+    // Or we may be the same channel with a full window already requested.
     if (request.inventories().empty())
         return;
 
@@ -110,18 +110,19 @@ bool protocol_block_sync::handle_receive_block(const code& ec,
             << "protocol_block_sync::handle_receive_block ***********************************************************";
 
 
-    // Add the block to the blockchain store.
+    // Queue the block for checks and storage, which do not block this read.
     reservation_->import(message);
 
-    if (reservation_->toggle_partitioned())
+    if (reservation_->toggle_rejected())
     {
         LOG_DEBUG(LOG_NODE)
-            << "Restarting partitioned slot (" << reservation_->slot() << ").";
+            << "Restarting slot with invalid block (" << reservation_->slot()
+            << ").";
         complete(error::channel_stopped);
         return false;
     }
 
-    // Request more blocks if our reservation has been expanded.
+    // Refill the window of blocks in flight.
     send_get_blocks(complete, false);
     return true;
 }
@@ -152,6 +153,15 @@ void protocol_block_sync::handle_event(const code& ec, event_handler complete)
         return;
     }
 
+    if (reservation_->toggle_rejected())
+    {
+        LOG_DEBUG(LOG_NODE)
+            << "Restarting slot with invalid block (" << reservation_->slot()
+            << ").";
+        complete(error::channel_stopped);
+        return;
+    }
+
     if (reservation_->expired())
     {
         LOG_DEBUG(LOG_NODE)
@@ -159,6 +169,12 @@ void protocol_block_sync::handle_event(const code& ec, event_handler complete)
         complete(error::channel_timeout);
         return;
     }
+
+    // Repopulate a row emptied by discarding blocks received by another.
+    reservation_->populate();
+
+    // Refill a window that paused while block stores were backlogged.
+    send_get_blocks(complete, false);
 }
 
 void protocol_block_sync::blocks_complete(const code& ec,
@@ -37,22 +37,22 @@ using namespace bc::message;
 using namespace bc::network;
 using namespace std::placeholders;
 
-// The interval in which header download rate is measured and tested.
+// The interval in which a racing peer must respond.
 static const asio::seconds expiry_interval(5);
 
+// The number of consecutive rounds a peer may lose before it is replaced.
+static constexpr size_t maximum_losses = 3;
+
+// The number of get_headers requests a peer may have outstanding.
+static constexpr size_t maximum_requests = 2;
+
 // This class requires protocol version 31800.
 protocol_header_sync::protocol_header_sync(full_node& network,
-    channel::ptr channel, header_list::ptr headers, uint32_t minimum_rate)
+    channel::ptr channel, header_list::ptr headers)
   : protocol_timer(network, channel, true, NAME),
     headers_(headers),
-
-    // TODO: replace rate backoff with peer competition.
-    //=========================================================================
-    current_second_(0),
-    minimum_rate_(minimum_rate),
-    start_size_(headers->previous_height() - headers->first_height()),
-    //=========================================================================
-
+    losses_(0),
+    responses_(0),
     CONSTRUCT_TRACK(protocol_header_sync)
 {
 }
@@ -70,26 +70,26 @@ void protocol_header_sync::start(event_handler handler)
     SUBSCRIBE3(headers, handle_receive_headers, _1, _2, complete);
 
     // This is the end of the start sequence.
-    send_get_headers(complete);
+    send_get_headers(headers_->previous_hash());
 }
 
 // Header sync sequence.
 // ----------------------------------------------------------------------------
 
-void protocol_header_sync::send_get_headers(event_handler complete)
+void protocol_header_sync::send_get_headers(const hash_digest& anchor)
 {
     if (stopped())
         return;
 
+    // Other peers race on the same slot, so the anchor may be overtaken.
+    anchors_.push_back(anchor);
+
     const get_headers request
     {
-        { headers_->previous_hash() },
+        { anchor },
         headers_->stop_hash()
     };
 
-    LOG_INFO(LOG_NODE)
-            << "protocol_header_sync::send_get_headers [" << authority() << "]";
-
     SEND2(request, handle_send, _1, request.command);
 }
 
@@ -99,17 +99,49 @@ bool protocol_header_sync::handle_receive_headers(const code& ec,
     if (stopped(ec))
         return false;
 
+    ++responses_;
+    const auto& headers = message->elements();
+
+    // Responses are received in the order of the requests.
+    if (anchors_.empty() || (!headers.empty() &&
+        headers.front().previous_block_hash() != anchors_.front()))
+    {
+        LOG_WARNING(LOG_NODE)
+            << "Unrequested headers from [" << authority() << "]";
+        complete(error::invalid_previous_block);
+        return false;
+    }
+
+    anchors_.pop_front();
+
+    // Request the next range from the unvalidated message so that the round
+    // trip overlaps the merge. A failed merge is discarded by the list.
+    if (headers.size() == max_get_headers &&
+        anchors_.size() < maximum_requests)
+    {
+        const auto last = headers.back().hash();
+
+        if (last != headers_->stop_hash())
+            send_get_headers(last);
+    }
+
     const auto start = headers_->previous_height() + 1;
+    auto overtaken = false;
 
-    // A merge failure resets the headers list.
-    if (!headers_->merge(message))
+    if (!headers_->merge(message, overtaken))
     {
         LOG_WARNING(LOG_NODE)
             << "Failure merging headers from [" << authority() << "]";
+        anchors_.clear();
         complete(error::invalid_previous_block);
         return false;
     }
 
+    // The slot was extended past the anchor by a faster peer.
+    if (overtaken)
+        return handle_lost_round(complete);
+
+    losses_ = 0;
     const auto end = headers_->previous_height();
 
     LOG_INFO(LOG_NODE)
@@ -123,14 +155,41 @@ bool protocol_header_sync::handle_receive_headers(const code& ec,
     }
 
     // If we received fewer than 2000 the peer is exhausted, try another.
-    if (message->elements().size() < max_get_headers)
+    if (headers.size() < max_get_headers)
     {
         complete(error::operation_failed);
         return false;
     }
 
     // This peer has more headers.
-    send_get_headers(complete);
+    if (anchors_.empty())
+        send_get_headers(headers_->previous_hash());
+
+    return true;
+}
+
+// Race from the new slot tip, unless this peer keeps losing.
+bool protocol_header_sync::handle_lost_round(event_handler complete)
+{
+    if (headers_->complete())
+    {
+        complete(error::success);
+        return false;
+    }
+
+    if (++losses_ >= maximum_losses)
+    {
+        LOG_DEBUG(LOG_NODE)
+            << "Header sync peer lost " << losses_ << " rounds ["
+            << authority() << "]";
+        complete(error::channel_timeout);
+        return false;
+    }
+
+    // A pipelined request usually extends the tip set by the winner.
+    if (anchors_.empty())
+        send_get_headers(headers_->previous_hash());
+
     return true;
 }
 
@@ -149,19 +208,18 @@ void protocol_header_sync::handle_event(const code& ec, event_handler complete)
         return;
     }
 
-    // TODO: replace rate backoff with peer competition.
-    //=========================================================================
-    // It was a timeout so another expiry period has passed (overflow ok here).
-    current_second_ += static_cast<size_t>(expiry_interval.count());
-    auto rate = (headers_->previous_height() - start_size_) / current_second_;
-    //=========================================================================
+    // The slot was completed by another peer, release this one.
+    if (headers_->complete())
+    {
+        complete(error::success);
+        return;
+    }
 
-    // Drop the channel if it falls below the min sync rate averaged over all.
-    if (rate < minimum_rate_)
+    // Drop the channel if it has not responded within the interval.
+    if (responses_.exchange(0) == 0)
     {
         LOG_DEBUG(LOG_NODE)
-            << "Header sync rate (" << rate << "/sec) from ["
-            << authority() << "]";
+            << "Header sync peer stalled [" << authority() << "]";
         complete(error::channel_timeout);
         return;
     }
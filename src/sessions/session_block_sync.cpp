@@ -28,6 +28,7 @@
 #include <bitcoin/node/settings.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
+#include <bitcoin/node/utility/sync_journal.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -44,11 +45,29 @@ using namespace std::placeholders;
 // The interval in which all-channel block download performance is tested.
 static const asio::seconds regulator_interval(5);
 
+// The share of row time spent in the store at which the store is saturated.
+static constexpr double maximum_database_ratio = 0.5;
+
+// The relative aggregate throughput gain that justifies another row.
+static constexpr double minimum_throughput_gain = 1.05;
+
+// The number of regulator intervals between saves of the sync journal, which
+// under strict durability is saved every interval.
+static constexpr size_t relaxed_journal_ticks = 12;
+static constexpr size_t strict_journal_ticks = 1;
+
 session_block_sync::session_block_sync(full_node& network, check_list& hashes,
+    sync_journal& journal, height_bitmap& populated, size_profile& sizes,
     fast_chain& chain, const settings& settings)
   : session<network::session_outbound>(network, false),
     chain_(chain),
-    reservations_(hashes, chain, settings),
+    journal_(journal),
+    journal_ticks_(settings.sync_relaxed ? relaxed_journal_ticks :
+        strict_journal_ticks),
+    reservations_(hashes, populated, sizes, chain, settings),
+    completed_(false),
+    throughput_(0),
+    ticks_(0),
     CONSTRUCT_TRACK(session_block_sync)
 {
 }
@@ -92,14 +111,15 @@ void session_block_sync::handle_started(const code& ec, result_handler handler)
         return;
     }
 
-    const auto complete = synchronize<result_handler>(
-        BIND2(handle_complete, _1, handler), table.size(), NAME);
+    // Rows are added and retired by the regulator, so the sequence completes
+    // when the reservation table is emptied.
+    complete_ = BIND2(handle_complete, _1, handler);
 
     // This is the end of the start sequence.
     for (const auto row: table)
-        new_connection(row, complete);
+        new_connection(row, complete_);
 
-    ////reset_timer();
+    reset_timer();
 }
 
 // Block sync sequence.
@@ -201,12 +221,18 @@ void session_block_sync::handle_channel_complete(const code& ec,
         return;
     }
 
-    timer_->stop();
-    reservations_.remove(row);
+    const auto emptied = reservations_.remove(row);
 
     LOG_DEBUG(LOG_NODE)
         << "Completed block slot (" << row->slot() << ")";
 
+    // A failed store may have completed the sequence already.
+    if (!emptied || completed_.exchange(true))
+        return;
+
+    // A cancelled timer handler may still be queued, so it must not re-arm.
+    timer_->stop();
+
     // This is the end of the block sync sequence.
     handler(error::success);
 }
@@ -241,6 +267,11 @@ void session_block_sync::handle_complete(const code& ec,
         return;
     }
 
+    // There is nothing left to resume.
+    if (!journal_.clear())
+        LOG_DEBUG(LOG_NODE)
+            << "Failed to remove sync journal.";
+
     LOG_DEBUG(LOG_NODE)
         << "Completed block sync.";
     handler(ec);
@@ -252,7 +283,7 @@ void session_block_sync::handle_complete(const code& ec,
 // private:
 void session_block_sync::reset_timer()
 {
-    if (stopped())
+    if (stopped() || completed_)
         return;
 
     timer_->start(BIND1(handle_timer, _1));
@@ -260,24 +291,102 @@ void session_block_sync::reset_timer()
 
 void session_block_sync::handle_timer(const code& ec)
 {
-    if (stopped())
+    // The timer is cancelled once the reservation table is emptied, after
+    // which the reservations are stopped and must not be regulated.
+    if (stopped() || completed_ || ec)
         return;
 
     LOG_DEBUG(LOG_NODE)
         << "Fired session_block_sync timer: " << ec.message();
 
-    ////// TODO: If (total database time as a fn of total time) add a channel.
-    ////// TODO: push into reservations_ implementation.
-    ////// TODO: add a boolean increment method to the synchronizer and pass here.
-    ////const size_t id = reservations_.table().size();
-    ////const auto row = std::make_shared<reservation>(reservations_, id);
-    ////const synchronizer<result_handler> handler({}, 0, "name", true);
-    ////if (add) new_connection(row, handler);
-    ////// TODO: drop the slowest channel
-    //////If (drop) reservations_.prune();
+    // A block that fails to store leaves a gap that sync cannot fill.
+    if (reservations_.failed())
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Failed to store synced blocks, stopping block sync.";
+
+        if (!completed_.exchange(true))
+            complete_(error::operation_failed);
+
+        return;
+    }
+
+    // All rows may complete while blocks await checks. A rejected block is
+    // then listed again, so a row is added to request it, and the sequence
+    // completes once the checks have drained.
+    if (reservations_.table().empty())
+    {
+        const auto row = reservations_.expand();
+
+        if (row)
+        {
+            LOG_DEBUG(LOG_NODE)
+                << "Rejected blocks listed, added block slot (" << row->slot()
+                << ").";
+            new_connection(row, complete_);
+        }
+        else if (reservations_.drained())
+        {
+            if (!completed_.exchange(true))
+                complete_(error::success);
+
+            return;
+        }
+    }
+
+    const auto rescued = reservations_.rescue();
+
+    if (rescued > 0)
+        LOG_DEBUG(LOG_NODE)
+            << "Requested " << rescued << " stalled blocks from faster slots.";
+
+    regulate();
+
+    // Stored heights are logged by the journal, limiting work on restart.
+    if (++ticks_ % journal_ticks_ == 0 && !journal_.save(chain_))
+        LOG_DEBUG(LOG_NODE)
+            << "Failed to save sync journal.";
 
     reset_timer();
 }
 
+// Add a row while aggregate throughput rises and the store keeps up, and
+// retire the slowest row once the store becomes the bottleneck.
+void session_block_sync::regulate()
+{
+    const auto statistics = reservations_.rates();
+
+    // Rates are not established until rows have imported blocks.
+    if (statistics.active_count == 0)
+        return;
+
+    const auto throughput = statistics.throughput;
+    const auto rising = throughput >= throughput_ * minimum_throughput_gain;
+    throughput_ = throughput;
+
+    if (statistics.database_ratio > maximum_database_ratio)
+    {
+        if (reservations_.contract())
+            LOG_DEBUG(LOG_NODE)
+                << "Store saturated (" << statistics.database_ratio * 100
+                << "%), retired slowest block slot.";
+
+        return;
+    }
+
+    if (!rising)
+        return;
+
+    const auto row = reservations_.expand();
+
+    if (!row)
+        return;
+
+    LOG_DEBUG(LOG_NODE)
+        << "Throughput rising, added block slot (" << row->slot() << ").";
+
+    new_connection(row, complete_);
+}
+
 } // namespace node
 } // namespace libbitcoin
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <memory>
 #include <utility>
 #include <bitcoin/blockchain.hpp>
@@ -30,6 +31,7 @@
 #include <bitcoin/node/full_node.hpp>
 #include <bitcoin/node/settings.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -44,24 +46,21 @@ using namespace bc::message;
 using namespace bc::network;
 using namespace std::placeholders;
 
-// The minimum rate back off factor, must be < 1.0.
-static constexpr float back_off_factor = 0.75f;
-
-// The starting minimum header download rate, exponentially backs off.
-static constexpr uint32_t headers_per_second = 10000;
+// The number of peers racing to fill each slot.
+static constexpr size_t racers_per_slot = 3;
 
 // Sort is required here but not in configuration settings.
 session_header_sync::session_header_sync(full_node& network,
-    check_list& hashes, fast_chain& blockchain,
-    const checkpoint::list& checkpoints)
+    check_list& hashes, height_bitmap& populated, fast_chain& blockchain,
+    const checkpoint::list& checkpoints, const settings& settings)
   : session<network::session_outbound>(network, false),
     hashes_(hashes),
-    minimum_rate_(headers_per_second),
+    populated_(populated),
     chain_(blockchain),
     checkpoints_(checkpoint::sort(checkpoints)),
+    slots_(std::max(settings.sync_peers, 1u)),
     CONSTRUCT_TRACK(session_header_sync)
 {
-    static_assert(back_off_factor < 1.0, "invalid back-off factor");
 }
 
 // Start sequence.
@@ -91,11 +90,25 @@ void session_header_sync::handle_started(const code& ec,
         return;
     }
 
+    if (headers_.empty())
+    {
+        LOG_DEBUG(LOG_NODE)
+            << "No headers required.";
+        handler(error::success);
+        return;
+    }
+
     const auto complete = synchronize(handler, headers_.size(), NAME);
 
     // This is the end of the start sequence.
     for (const auto row: headers_)
-        new_connection(row, complete);
+    {
+        // Only the first racer to complete the slot is counted.
+        const auto slot_complete = synchronize(complete, 1, NAME);
+
+        for (size_t racer = 0; racer < racers_per_slot; ++racer)
+            new_connection(row, slot_complete);
+    }
 }
 
 // Header sync sequence.
@@ -111,6 +124,9 @@ void session_header_sync::new_connection(header_list::ptr row,
         return;
     }
 
+    if (row->complete())
+        return;
+
     LOG_DEBUG(LOG_NODE)
         << "Starting header slot (" << row->slot() << ").";
 
@@ -185,39 +201,26 @@ void session_header_sync::attach_protocols(channel::ptr channel,
         attach<protocol_ping_31402>(channel)->start();
 
     attach<protocol_address_31402>(channel)->start();
-    attach<protocol_header_sync>(channel, row, minimum_rate_)->start(
+    attach<protocol_header_sync>(channel, row)->start(
         BIND3(handle_complete, _1, row, handler));
 }
 
 void session_header_sync::handle_complete(const code& ec,
     header_list::ptr row, result_handler handler)
 {
-    if (ec)
+    // A racer that lost or failed is replaced by a new challenger.
+    if (!row->complete())
     {
-        // Reduce the rate minimum so that we don't get hung up.
-        minimum_rate_ = static_cast<uint32_t>(minimum_rate_ * back_off_factor);
-
         // There is no failure scenario, we ignore the result code here.
         new_connection(row, handler);
         return;
     }
 
-    //*************************************************************************
-    // TODO: as each header sink slot completes store headers to database and
-    // assign its checkpoints to hashes_, terminating the slot.
-    //*************************************************************************
-
-    auto height = row->first_height();
-    const auto& headers = row->headers();
-
-    // Store the hash if there is a gap reservation.
-    for (const auto& header: headers)
-        hashes_.enqueue(header.hash(), height++);
-
+    // The headers of the slot have been stored to hashes_ as they merged.
     LOG_DEBUG(LOG_NODE)
         << "Completed header slot (" << row->slot() << ")";
 
-    // This is the end of the header sync sequence.
+    // This is the end of the header sync sequence (repeats are ignored).
     handler(error::success);
 }
 
@@ -234,35 +237,133 @@ void session_header_sync::handle_channel_stop(const code& ec,
 
 bool session_header_sync::initialize()
 {
+    // The hash list is initialized only when resumed from a sync journal.
     if (!hashes_.empty()) {
+        size_t first_height;
+
+        // Only headers from the first unknown hash remain to be synced.
+        if (hashes_.missing(first_height)) {
+            initialize_slots(first_height);
+        }
+
+        LOG_INFO(LOG_NODE)
+            << "Resumed " << hashes_.size() << " missing blocks from the "
+            << "sync journal.";
+        return true;
+    }
+
+    size_t top;
+    if ( ! chain_.get_last_height(top)) {
         LOG_ERROR(LOG_NODE)
-            << "Block hash list must not be initialized.";
+            << "The blockchain is corrupt.";
         return false;
     }
 
-    //LOG_INFO(LOG_NODE) << "asm int $3 - 14";
-    //asm("int $3");  //TODO(fernando): remover
+    check_list::heights gaps;
+
 #ifdef BITPRIM_DB_LEGACY     
-    block_database::heights gaps;
-    // Populate hash buckets from full database empty height scan.
-    if ( ! chain_.get_gaps(gaps)) {
-        return false;
+    // Empty heights come from the bitmap saved on the last clean stop. The
+    // full database empty height scan is only required to rebuild it.
+    if (populated_.valid()) {
+        populated_.gaps(gaps, top);
+    } else {
+        if ( ! chain_.get_gaps(gaps)) {
+            return false;
+        }
+
+        populated_.assign(gaps, top);
+    }
+#endif // BITPRIM_DB_LEGACY     
+
+    if (checkpoints_.size() < 2) {
+        return true;
     }
+
+    // Only headers between the first and last checkpoint can be verified.
+    const auto first = checkpoints_.front().height();
+    const auto last = checkpoints_.back().height();
+    const auto unverifiable = [first, last](size_t height) {
+        return height <= first || height > last;
+    };
+
+    gaps.erase(std::remove_if(gaps.begin(), gaps.end(), unverifiable),
+        gaps.end());
+
+    // Every store is missing the heights above its top, up to the last
+    // checkpoint. Sequential stores (BITPRIM_DB_NEW) have no other gaps.
+    const auto start = std::max(first, top);
+
+    for (auto height = safe_add(start, size_t(1)); height <= last; ++height) {
+        gaps.push_back(height);
+    }
+
+    // Headers below the first gap are not required.
+    if (gaps.empty()) {
+        return true;
+    }
+
     // TODO: consider populating this directly in the database.
     hashes_.reserve(gaps);
-//#else
-   //return false;
-#endif // BITPRIM_DB_LEGACY     
 
-    //*************************************************************************
-    // TODO: get top and pair up checkpoints into slots.
-    const auto& front = checkpoints_.front();
-    const auto& back = checkpoints_.back();
-    headers_.push_back(std::make_shared<header_list>(0, front, back));
-    //*************************************************************************
+    LOG_INFO(LOG_NODE)
+        << "Found " << gaps.size() << " missing blocks below checkpoint ("
+        << last << ").";
 
+    const auto first_height = *std::min_element(gaps.begin(), gaps.end());
+    initialize_slots(first_height);
     return true;
 }
 
+// Pair up checkpoints into at most one slot per configured sync peer. Each
+// slot spans a checkpoint interval of roughly equal height, and is verified
+// against the checkpoint at each end, so completed slots link to each other.
+void session_header_sync::initialize_slots(size_t first_height)
+{
+    if (checkpoints_.size() < 2)
+        return;
+
+    const auto last = std::prev(checkpoints_.end());
+
+    // Headers above the last checkpoint cannot be verified here.
+    if (first_height > last->height())
+        return;
+
+    auto start = checkpoints_.begin();
+
+    // Start from the highest checkpoint below the first required header.
+    for (auto it = start; it != last && it->height() < first_height; ++it)
+        start = it;
+
+    const auto base = start->height();
+    const auto span = last->height() - base;
+    const auto intervals = static_cast<size_t>(std::distance(start, last));
+    const auto slots = std::min(slots_, intervals);
+
+    // Guard against division by zero.
+    if (slots == 0)
+        return;
+
+    headers_.reserve(slots);
+
+    for (size_t slot = 1; start != last && slot <= slots; ++slot)
+    {
+        // The stop of the final slot is always the last checkpoint.
+        const auto target = base + (span / slots) * slot;
+        const auto reached = [&](const checkpoint& check)
+        {
+            return slot == slots ? false : check.height() >= target;
+        };
+
+        auto stop = std::find_if(std::next(start), last, reached);
+        headers_.push_back(std::make_shared<header_list>(headers_.size(),
+            *start, *stop, hashes_));
+        start = stop;
+    }
+
+    LOG_DEBUG(LOG_NODE)
+        << "Partitioned headers " << base << "-" << last->height() << " into "
+        << headers_.size() << " slots.";
+}
+
 } // namespace node
 } // namespace libbitcoin
@@ -28,6 +28,8 @@ using namespace bc::asio;
 settings::settings()
     : sync_peers(0)
     , sync_timeout_seconds(5)
+    , sync_window(64)
+    , sync_relaxed(true)
     , block_latency_seconds(60)
     , refresh_transactions(true)
     , rpc_port(8332)
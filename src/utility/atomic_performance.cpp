@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/atomic_performance.hpp>
+
+#include <atomic>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/utility/performance.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+atomic_performance::atomic_performance(const performance& value)
+  : sequence_(0),
+    idle_(value.idle),
+    events_(value.events),
+    database_(value.database),
+    window_(value.window)
+{
+}
+
+performance atomic_performance::load() const
+{
+    performance value;
+    uint32_t before;
+    uint32_t after;
+
+    do
+    {
+        before = sequence_.load(std::memory_order_acquire);
+        value.idle = idle_.load(std::memory_order_relaxed);
+        value.events = events_.load(std::memory_order_relaxed);
+        value.database = database_.load(std::memory_order_relaxed);
+        value.window = window_.load(std::memory_order_relaxed);
+
+        // Order the field loads before the sequence reload.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence_.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1u) != 0);
+
+    return value;
+}
+
+bool atomic_performance::idle() const
+{
+    return idle_.load(std::memory_order_acquire);
+}
+
+void atomic_performance::store(const performance& value)
+{
+    const auto sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1u, std::memory_order_relaxed);
+
+    // Order the odd sequence before the field stores.
+    std::atomic_thread_fence(std::memory_order_release);
+    idle_.store(value.idle, std::memory_order_relaxed);
+    events_.store(value.events, std::memory_order_relaxed);
+    database_.store(value.database, std::memory_order_relaxed);
+    window_.store(value.window, std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2u, std::memory_order_release);
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,218 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/block_requests.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+block_requests::block_requests(size_t limit, clock::duration timeout)
+  : sequence_(0), limit_(limit), timeout_(timeout)
+{
+}
+
+size_t block_requests::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return flights_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_requests::count(uint64_t peer) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = counts_.find(peer);
+    return it == counts_.end() ? 0 : it->second;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_requests::claim(uint64_t peer, const hash_list& hashes,
+    hash_list& out, clock::time_point now)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    for (const auto& hash: hashes)
+    {
+        auto it = flights_.find(hash);
+
+        if (it == flights_.end())
+            it = flights_.emplace(hash,
+                flight{ sequence_++, false, 0, now, {} }).first;
+
+        auto& value = it->second;
+
+        // A repeated request from the holder restarts its timeout.
+        if (value.assigned && value.peer == peer)
+        {
+            value.since = now;
+            out.push_back(hash);
+            continue;
+        }
+
+        if (value.assigned && now - value.since >= timeout_)
+            unassign(value);
+
+        if (!value.assigned && assign(value, peer, now))
+        {
+            out.push_back(hash);
+            continue;
+        }
+
+        auto& waiters = value.waiters;
+        if (std::find(waiters.begin(), waiters.end(), peer) == waiters.end())
+            waiters.push_back(peer);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_requests::reclaim(uint64_t peer, hash_list& out,
+    clock::time_point now)
+{
+    std::vector<std::pair<size_t, flights::iterator>> available;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    for (auto it = flights_.begin(); it != flights_.end(); ++it)
+    {
+        const auto& value = it->second;
+        const auto& waiters = value.waiters;
+
+        if ((!value.assigned || now - value.since >= timeout_) &&
+            std::find(waiters.begin(), waiters.end(), peer) != waiters.end())
+            available.emplace_back(value.sequence, it);
+    }
+
+    std::sort(available.begin(), available.end(),
+        [](const std::pair<size_t, flights::iterator>& left,
+            const std::pair<size_t, flights::iterator>& right)
+        {
+            return left.first < right.first;
+        });
+
+    for (const auto& entry: available)
+    {
+        auto& value = entry.second->second;
+
+        if (value.assigned)
+            unassign(value);
+
+        if (!assign(value, peer, now))
+            break;
+
+        auto& waiters = value.waiters;
+        waiters.erase(std::find(waiters.begin(), waiters.end(), peer));
+        out.push_back(entry.second->first);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool block_requests::complete(uint64_t peer, const hash_digest& hash)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto it = flights_.find(hash);
+
+    if (it == flights_.end())
+        return false;
+
+    auto& value = it->second;
+    const auto held = value.assigned && value.peer == peer;
+
+    if (value.assigned)
+        unassign(value);
+
+    flights_.erase(it);
+    return held;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_requests::release(uint64_t peer)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    for (auto it = flights_.begin(); it != flights_.end();)
+    {
+        auto& value = it->second;
+        auto& waiters = value.waiters;
+        waiters.erase(std::remove(waiters.begin(), waiters.end(), peer),
+            waiters.end());
+
+        if (value.assigned && value.peer == peer)
+            unassign(value);
+
+        // A block that no peer holds or waits on is no longer tracked.
+        it = !value.assigned && waiters.empty() ? flights_.erase(it) :
+            std::next(it);
+    }
+
+    counts_.erase(peer);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+bool block_requests::assign(flight& value, uint64_t peer,
+    clock::time_point now)
+{
+    auto& count = counts_[peer];
+
+    if (count >= limit_)
+        return false;
+
+    ++count;
+    value.assigned = true;
+    value.peer = peer;
+    value.since = now;
+    return true;
+}
+
+void block_requests::unassign(flight& value)
+{
+    const auto it = counts_.find(value.peer);
+
+    if (it != counts_.end() && --it->second == 0)
+        counts_.erase(it);
+
+    value.assigned = false;
+}
+
+} // namespace node
+} // namespace libbitcoin
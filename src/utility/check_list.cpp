@@ -18,23 +18,30 @@
  */
 #include <bitcoin/node/utility/check_list.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
-#include <boost/bimap/support/lambda.hpp>
 #include <bitcoin/blockchain.hpp>
 
 namespace libbitcoin {
 namespace node {
 
+using namespace bc::config;
 using namespace bc::database;
 
+check_list::check_list()
+  : base_(0), cursor_(0), count_(0)
+{
+}
+
 bool check_list::empty() const
 {
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     shared_lock lock(mutex_);
 
-    return checks_.empty();
+    return count_ == 0;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -44,7 +51,7 @@ size_t check_list::size() const
     // Critical Section
     shared_lock lock(mutex_);
 
-    return checks_.size();
+    return count_;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -54,31 +61,48 @@ void check_list::reserve(const heights& heights)
     // Critical Section
     unique_lock lock(mutex_);
 
-    checks_.clear();
+    hashes_.clear();
+    reserved_.clear();
+    base_ = 0;
+    cursor_ = 0;
+    count_ = 0;
 
-    for (const auto height : heights) {
-        const auto it = checks_.insert({ null_hash, height });
-    }
+    if (heights.empty())
+        return;
 
+    // The span covers the reserved range, gaps are marked unreserved.
+    const auto range = std::minmax_element(heights.begin(), heights.end());
+    base_ = *range.first;
+    const auto span = *range.second - base_ + 1;
+    hashes_.assign(span, null_hash);
+    reserved_.assign(span, false);
+
+    for (const auto height: heights)
+    {
+        const auto offset = height - base_;
+
+        if (!reserved_[offset])
+        {
+            reserved_[offset] = true;
+            ++count_;
+        }
+    }
     ///////////////////////////////////////////////////////////////////////////
 }
 
-
 void check_list::enqueue(hash_digest&& hash, size_t height)
 {
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
     unique_lock lock(mutex_);
 
-    using namespace boost::bimaps;
-    const auto it = checks_.right.find(height);
-
     // Ignore the entry if it is not reserved.
-    if (it == checks_.right.end())
+    if (height < base_ || height - base_ >= reserved_.size() ||
+        !reserved_[height - base_])
         return;
 
-    BITCOIN_ASSERT(it->second == null_hash);
-    checks_.right.modify_data(it, _data = std::move(hash));
+    // A reserved entry may be overwritten by a restarted header slot.
+    hashes_[height - base_] = std::move(hash);
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -89,16 +113,143 @@ bool check_list::dequeue(hash_digest& out_hash, size_t& out_height)
     unique_lock lock(mutex_);
 
     // Overlocking to reduce code in the dominant path.
-    if (checks_.empty())
+    if (count_ == 0)
+        return false;
+
+    seek();
+    out_height = base_ + cursor_;
+    out_hash = hashes_[cursor_];
+    reserved_[cursor_++] = false;
+    --count_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t check_list::dequeue(checkpoint::list& out, size_t count)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto taken = std::min(count, count_);
+    out.reserve(out.size() + taken);
+
+    for (size_t entry = 0; entry < taken; ++entry)
+    {
+        seek();
+        out.emplace_back(hashes_[cursor_], base_ + cursor_);
+        reserved_[cursor_++] = false;
+    }
+
+    count_ -= taken;
+    return taken;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t check_list::dequeue(checkpoint::list& out, size_t count,
+    uint64_t budget, const size_profile& profile)
+{
+    uint64_t bytes = 0;
+    size_t taken = 0;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    for (; taken < count && count_ > 0 && bytes < budget; ++taken)
+    {
+        seek();
+        const auto height = base_ + cursor_;
+        bytes += profile.estimate(height);
+        out.emplace_back(hashes_[cursor_], height);
+        reserved_[cursor_++] = false;
+        --count_;
+    }
+
+    return taken;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void check_list::restore(hash_digest&& hash, size_t height)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // Only dequeued entries are restored, which are within the span.
+    if (height < base_ || height - base_ >= reserved_.size() ||
+        reserved_[height - base_])
+        return;
+
+    const auto offset = height - base_;
+    hashes_[offset] = std::move(hash);
+    reserved_[offset] = true;
+    cursor_ = std::min(cursor_, offset);
+    ++count_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool check_list::take(hash_digest& out_hash, size_t height)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (height < base_ || height - base_ >= reserved_.size() ||
+        !reserved_[height - base_])
         return false;
 
-    auto it = checks_.right.begin();
-    out_height = it->first;
-    out_hash = it->second;
-    checks_.right.erase(it);
+    // Entries above the cursor remain reserved, so seek is unaffected.
+    const auto offset = height - base_;
+    out_hash = hashes_[offset];
+    reserved_[offset] = false;
+    --count_;
     return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
+void check_list::snapshot(checkpoint::list& out) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    out.reserve(out.size() + count_);
+
+    for (auto offset = cursor_; offset < reserved_.size(); ++offset)
+        if (reserved_[offset])
+            out.emplace_back(hashes_[offset], base_ + offset);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool check_list::missing(size_t& out_height) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    for (auto offset = cursor_; offset < reserved_.size(); ++offset)
+    {
+        if (reserved_[offset] && hashes_[offset] == null_hash)
+        {
+            out_height = base_ + offset;
+            return true;
+        }
+    }
+
+    return false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+// The caller must ensure that a reserved entry remains at or above cursor.
+void check_list::seek()
+{
+    while (!reserved_[cursor_])
+        ++cursor_;
+}
+
 } // namespace node
 } // namespace libbitcoin
@@ -0,0 +1,660 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/hash_batch.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define HASH_BATCH_X86
+    #define HASH_BATCH_TARGET(name) __attribute__((target(name)))
+    #include <cpuid.h>
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define HASH_BATCH_X86
+    #define HASH_BATCH_TARGET(name)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+
+// sha256 is defined over 64 byte blocks of big endian 32 bit words.
+static constexpr size_t block_size = 64;
+static constexpr size_t header_size = 80;
+static constexpr size_t avx2_lanes = 8;
+
+static const uint32_t initial[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t rounds[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Message padding.
+//-----------------------------------------------------------------------------
+
+// A message presented as a sequence of blocks, the last one or two of which
+// are copied into the tail with the sha256 padding and bit length appended.
+struct padded_message
+{
+    void initialize(const uint8_t* message, size_t size)
+    {
+        const auto rest = size % block_size;
+        data = message;
+        whole = size / block_size;
+        blocks = whole + (rest + 9 > block_size ? 2 : 1);
+
+        std::memset(tail, 0, sizeof(tail));
+
+        if (rest != 0)
+            std::memcpy(tail, message + whole * block_size, rest);
+
+        tail[rest] = 0x80;
+        const auto end = (blocks - whole) * block_size;
+        const auto bits = static_cast<uint64_t>(size) * 8;
+
+        for (size_t byte = 0; byte < 8; ++byte)
+            tail[end - 1 - byte] = static_cast<uint8_t>(bits >> (8 * byte));
+    }
+
+    const uint8_t* block(size_t index) const
+    {
+        return index < whole ? data + index * block_size :
+            tail + (index - whole) * block_size;
+    }
+
+    const uint8_t* data;
+    size_t whole;
+    size_t blocks;
+    uint8_t tail[2 * block_size];
+};
+
+// The single block of the second hash, a digest with its padding.
+static void pad_digest(uint8_t* block, const uint32_t* state)
+{
+    for (size_t word = 0; word < 8; ++word)
+    {
+        block[4 * word + 0] = static_cast<uint8_t>(state[word] >> 24);
+        block[4 * word + 1] = static_cast<uint8_t>(state[word] >> 16);
+        block[4 * word + 2] = static_cast<uint8_t>(state[word] >> 8);
+        block[4 * word + 3] = static_cast<uint8_t>(state[word]);
+    }
+
+    // The bit length of a digest is 256 (0x0100).
+    std::memset(block + hash_size, 0, block_size - hash_size);
+    block[hash_size] = 0x80;
+    block[block_size - 2] = 0x01;
+}
+
+static void to_digest(hash_digest& out, const uint32_t* state)
+{
+    for (size_t word = 0; word < 8; ++word)
+    {
+        out[4 * word + 0] = static_cast<uint8_t>(state[word] >> 24);
+        out[4 * word + 1] = static_cast<uint8_t>(state[word] >> 16);
+        out[4 * word + 2] = static_cast<uint8_t>(state[word] >> 8);
+        out[4 * word + 3] = static_cast<uint8_t>(state[word]);
+    }
+}
+
+static inline uint32_t read_word(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) |
+        (static_cast<uint32_t>(data[1]) << 16) |
+        (static_cast<uint32_t>(data[2]) << 8) |
+        static_cast<uint32_t>(data[3]);
+}
+
+// Scalar kernel.
+//-----------------------------------------------------------------------------
+
+static inline uint32_t rotate(uint32_t value, uint32_t bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static void transform_scalar(uint32_t* state, const uint8_t* block)
+{
+    uint32_t w[64];
+
+    for (size_t round = 0; round < 16; ++round)
+        w[round] = read_word(block + 4 * round);
+
+    for (size_t round = 16; round < 64; ++round)
+    {
+        const auto s0 = rotate(w[round - 15], 7) ^
+            rotate(w[round - 15], 18) ^ (w[round - 15] >> 3);
+        const auto s1 = rotate(w[round - 2], 17) ^
+            rotate(w[round - 2], 19) ^ (w[round - 2] >> 10);
+        w[round] = w[round - 16] + s0 + w[round - 7] + s1;
+    }
+
+    auto a = state[0], b = state[1], c = state[2], d = state[3];
+    auto e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (size_t round = 0; round < 64; ++round)
+    {
+        const auto s1 = rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25);
+        const auto choose = (e & f) ^ (~e & g);
+        const auto t1 = h + s1 + choose + rounds[round] + w[round];
+        const auto s0 = rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22);
+        const auto majority = (a & b) ^ (a & c) ^ (b & c);
+        const auto t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+#ifdef HASH_BATCH_X86
+
+// Processor support.
+//-----------------------------------------------------------------------------
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b,
+    uint32_t& c, uint32_t& d)
+{
+#ifdef _MSC_VER
+    int registers[4];
+    __cpuidex(registers, leaf, subleaf);
+    a = registers[0];
+    b = registers[1];
+    c = registers[2];
+    d = registers[3];
+#else
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+#endif
+}
+
+// The operating system preserves the extended (ymm) register state.
+static bool avx_state_enabled()
+{
+#ifdef _MSC_VER
+    return (_xgetbv(0) & 0x06) == 0x06;
+#else
+    uint32_t low, high;
+    __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (low & 0x06) == 0x06;
+#endif
+}
+
+static bool cpu_supports(hash_batch::kernel engine)
+{
+    uint32_t a, b, c, d;
+    cpuid(0, 0, a, b, c, d);
+
+    if (a < 7)
+        return false;
+
+    cpuid(1, 0, a, b, c, d);
+    const auto ssse3 = (c & (1u << 9)) != 0;
+    const auto sse41 = (c & (1u << 19)) != 0;
+    const auto osxsave = (c & (1u << 27)) != 0;
+
+    cpuid(7, 0, a, b, c, d);
+    const auto avx2 = (b & (1u << 5)) != 0;
+    const auto sha = (b & (1u << 29)) != 0;
+
+    switch (engine)
+    {
+        case hash_batch::kernel::avx2:
+            return avx2 && osxsave && avx_state_enabled();
+        case hash_batch::kernel::shani:
+            return sha && ssse3 && sse41;
+        default:
+            return true;
+    }
+}
+
+// SHA extensions kernel.
+//-----------------------------------------------------------------------------
+
+HASH_BATCH_TARGET("sha,sse4.1")
+static inline void quad_round(__m128i& state0, __m128i& state1,
+    __m128i message, size_t quad)
+{
+    const auto constants = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(rounds + 4 * quad));
+    const auto sum = _mm_add_epi32(message, constants);
+    state1 = _mm_sha256rnds2_epu32(state1, state0, sum);
+    state0 = _mm_sha256rnds2_epu32(state0, state1,
+        _mm_shuffle_epi32(sum, 0x0e));
+}
+
+HASH_BATCH_TARGET("sha,sse4.1")
+static void transform_shani(uint32_t* state, const uint8_t* block)
+{
+    const auto swap = _mm_set_epi64x(0x0c0d0e0f08090a0bull,
+        0x0405060700010203ull);
+
+    // Reorder the state into the abef/cdgh layout of the instructions.
+    auto t1 = _mm_shuffle_epi32(_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(state)), 0xb1);
+    auto t2 = _mm_shuffle_epi32(_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+    auto state0 = _mm_alignr_epi8(t1, t2, 8);
+    auto state1 = _mm_blend_epi16(t2, t1, 0xf0);
+    const auto save0 = state0;
+    const auto save1 = state1;
+
+    __m128i m[4];
+
+    for (size_t quad = 0; quad < 4; ++quad)
+    {
+        m[quad] = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(block + 16 * quad)), swap);
+        quad_round(state0, state1, m[quad], quad);
+
+        if (quad > 0 && quad < 3)
+            m[quad - 1] = _mm_sha256msg1_epu32(m[quad - 1], m[quad]);
+    }
+
+    // Each group of four message words is extended from the preceding four.
+    for (size_t quad = 4; quad < 16; ++quad)
+    {
+        auto& next = m[quad % 4];
+        auto& prior = m[(quad - 2) % 4];
+        const auto& last = m[(quad - 1) % 4];
+        next = _mm_sha256msg2_epu32(
+            _mm_add_epi32(next, _mm_alignr_epi8(last, prior, 4)), last);
+
+        if (quad < 14)
+            prior = _mm_sha256msg1_epu32(prior, last);
+
+        quad_round(state0, state1, next, quad);
+    }
+
+    state0 = _mm_add_epi32(state0, save0);
+    state1 = _mm_add_epi32(state1, save1);
+
+    // Restore the state to natural order.
+    t1 = _mm_shuffle_epi32(state0, 0x1b);
+    t2 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+        _mm_blend_epi16(t1, t2, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4),
+        _mm_alignr_epi8(t2, t1, 8));
+}
+
+// AVX2 kernel.
+//-----------------------------------------------------------------------------
+
+HASH_BATCH_TARGET("avx2")
+static inline __m256i rotate8(__m256i value, int bits)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(value, bits),
+        _mm256_slli_epi32(value, 32 - bits));
+}
+
+// The state is word major, eight lanes per word. Only lanes set in the mask
+// are updated, allowing messages of different lengths to share a batch.
+HASH_BATCH_TARGET("avx2")
+static void transform_avx2(uint32_t* state, const uint8_t* const* blocks,
+    const __m256i& mask)
+{
+    __m256i w[16];
+
+    for (size_t word = 0; word < 16; ++word)
+    {
+        const auto offset = 4 * word;
+        w[word] = _mm256_set_epi32(
+            read_word(blocks[7] + offset), read_word(blocks[6] + offset),
+            read_word(blocks[5] + offset), read_word(blocks[4] + offset),
+            read_word(blocks[3] + offset), read_word(blocks[2] + offset),
+            read_word(blocks[1] + offset), read_word(blocks[0] + offset));
+    }
+
+    __m256i saved[8];
+
+    for (size_t word = 0; word < 8; ++word)
+        saved[word] = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(state + avx2_lanes * word));
+
+    auto a = saved[0], b = saved[1], c = saved[2], d = saved[3];
+    auto e = saved[4], f = saved[5], g = saved[6], h = saved[7];
+
+    for (size_t round = 0; round < 64; ++round)
+    {
+        auto& word = w[round % 16];
+
+        if (round >= 16)
+        {
+            const auto& w15 = w[(round - 15) % 16];
+            const auto& w2 = w[(round - 2) % 16];
+            const auto s0 = _mm256_xor_si256(_mm256_xor_si256(rotate8(w15, 7),
+                rotate8(w15, 18)), _mm256_srli_epi32(w15, 3));
+            const auto s1 = _mm256_xor_si256(_mm256_xor_si256(rotate8(w2, 17),
+                rotate8(w2, 19)), _mm256_srli_epi32(w2, 10));
+            word = _mm256_add_epi32(_mm256_add_epi32(word, s0),
+                _mm256_add_epi32(w[(round - 7) % 16], s1));
+        }
+
+        const auto s1 = _mm256_xor_si256(_mm256_xor_si256(rotate8(e, 6),
+            rotate8(e, 11)), rotate8(e, 25));
+        const auto choose = _mm256_xor_si256(_mm256_and_si256(e, f),
+            _mm256_andnot_si256(e, g));
+        const auto t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+            _mm256_add_epi32(_mm256_add_epi32(choose,
+                _mm256_set1_epi32(static_cast<int>(rounds[round]))), word));
+        const auto s0 = _mm256_xor_si256(_mm256_xor_si256(rotate8(a, 2),
+            rotate8(a, 13)), rotate8(a, 22));
+        const auto majority = _mm256_xor_si256(_mm256_xor_si256(
+            _mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+            _mm256_and_si256(b, c));
+        const auto t2 = _mm256_add_epi32(s0, majority);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    const __m256i results[8] = { a, b, c, d, e, f, g, h };
+
+    for (size_t word = 0; word < 8; ++word)
+    {
+        const auto sum = _mm256_add_epi32(saved[word], results[word]);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(state + avx2_lanes * word),
+            _mm256_blendv_epi8(saved[word], sum, mask));
+    }
+}
+
+HASH_BATCH_TARGET("avx2")
+static void hash_avx2(hash_digest* out, const uint8_t* const* messages,
+    const size_t* sizes, size_t count)
+{
+    padded_message lanes[avx2_lanes];
+    uint32_t state[8 * avx2_lanes];
+    uint32_t lane_state[8];
+    uint8_t seconds[avx2_lanes][block_size];
+    const uint8_t* blocks[avx2_lanes];
+
+    for (size_t first = 0; first < count; first += avx2_lanes)
+    {
+        const auto used = std::min(avx2_lanes, count - first);
+        size_t blocks_count = 0;
+
+        // Unused lanes repeat the first message and are masked off.
+        for (size_t lane = 0; lane < avx2_lanes; ++lane)
+        {
+            const auto index = first + (lane < used ? lane : 0);
+            lanes[lane].initialize(messages[index], sizes[index]);
+            blocks_count = std::max(blocks_count, lanes[lane].blocks);
+        }
+
+        for (size_t word = 0; word < 8; ++word)
+            for (size_t lane = 0; lane < avx2_lanes; ++lane)
+                state[avx2_lanes * word + lane] = initial[word];
+
+        for (size_t index = 0; index < blocks_count; ++index)
+        {
+            int active[avx2_lanes];
+
+            for (size_t lane = 0; lane < avx2_lanes; ++lane)
+            {
+                const auto& message = lanes[lane];
+                const auto live = lane < used && index < message.blocks;
+                active[lane] = live ? -1 : 0;
+                blocks[lane] = message.block(std::min(index,
+                    message.blocks - 1));
+            }
+
+            const auto mask = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(active));
+            transform_avx2(state, blocks, mask);
+        }
+
+        // The second hash is a single block in every lane.
+        for (size_t lane = 0; lane < avx2_lanes; ++lane)
+        {
+            for (size_t word = 0; word < 8; ++word)
+            {
+                lane_state[word] = state[avx2_lanes * word + lane];
+                state[avx2_lanes * word + lane] = initial[word];
+            }
+
+            pad_digest(seconds[lane], lane_state);
+            blocks[lane] = seconds[lane];
+        }
+
+        transform_avx2(state, blocks, _mm256_set1_epi32(-1));
+
+        for (size_t lane = 0; lane < used; ++lane)
+        {
+            for (size_t word = 0; word < 8; ++word)
+                lane_state[word] = state[avx2_lanes * word + lane];
+
+            to_digest(out[first + lane], lane_state);
+        }
+    }
+}
+
+#else
+
+static bool cpu_supports(hash_batch::kernel engine)
+{
+    return engine == hash_batch::kernel::scalar;
+}
+
+#endif
+
+// Single lane driver.
+//-----------------------------------------------------------------------------
+
+typedef void(*transform_single)(uint32_t* state, const uint8_t* block);
+
+static void hash_single(hash_digest* out, const uint8_t* const* messages,
+    const size_t* sizes, size_t count, transform_single transform)
+{
+    padded_message message;
+    uint32_t state[8];
+    uint8_t second[block_size];
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        message.initialize(messages[index], sizes[index]);
+        std::copy(std::begin(initial), std::end(initial), state);
+
+        for (size_t block = 0; block < message.blocks; ++block)
+            transform(state, message.block(block));
+
+        pad_digest(second, state);
+        std::copy(std::begin(initial), std::end(initial), state);
+        transform(state, second);
+        to_digest(out[index], state);
+    }
+}
+
+// Engine.
+//-----------------------------------------------------------------------------
+
+hash_batch::hash_batch()
+  : engine_(fastest())
+{
+}
+
+hash_batch::hash_batch(kernel engine)
+  : engine_(supported(engine) ? engine : kernel::scalar)
+{
+}
+
+hash_batch::kernel hash_batch::engine() const
+{
+    return engine_;
+}
+
+bool hash_batch::supported(kernel engine)
+{
+    // Processor support is fixed, so it is detected once.
+    static const bool avx2 = cpu_supports(kernel::avx2);
+    static const bool shani = cpu_supports(kernel::shani);
+
+    switch (engine)
+    {
+        case kernel::avx2:
+            return avx2;
+        case kernel::shani:
+            return shani;
+        default:
+            return true;
+    }
+}
+
+// The sha extensions retire a single message faster than eight vector lanes.
+hash_batch::kernel hash_batch::fastest()
+{
+    if (supported(kernel::shani))
+        return kernel::shani;
+
+    if (supported(kernel::avx2))
+        return kernel::avx2;
+
+    return kernel::scalar;
+}
+
+void hash_batch::hash(hash_digest* out, const uint8_t* const* messages,
+    const size_t* sizes, size_t count) const
+{
+    switch (engine_)
+    {
+#ifdef HASH_BATCH_X86
+        case kernel::avx2:
+            hash_avx2(out, messages, sizes, count);
+            return;
+        case kernel::shani:
+            hash_single(out, messages, sizes, count, transform_shani);
+            return;
+#endif
+        default:
+            hash_single(out, messages, sizes, count, transform_scalar);
+            return;
+    }
+}
+
+void hash_batch::hash(hash_digest* out, const uint8_t* data, size_t size,
+    size_t count) const
+{
+    std::vector<const uint8_t*> messages(count);
+    const std::vector<size_t> sizes(count, size);
+
+    for (size_t index = 0; index < count; ++index)
+        messages[index] = data + index * size;
+
+    hash(out, messages.data(), sizes.data(), count);
+}
+
+hash_list hash_batch::hash(const header::list& headers) const
+{
+    data_chunk data;
+    data.reserve(headers.size() * header_size);
+
+    for (const auto& header: headers)
+    {
+        const auto serial = header.to_data();
+        data.insert(data.end(), serial.begin(), serial.end());
+    }
+
+    hash_list out(headers.size());
+    hash(out.data(), data.data(), header_size, headers.size());
+    return out;
+}
+
+hash_list hash_batch::hash(const transaction::list& transactions) const
+{
+    const auto count = transactions.size();
+    std::vector<data_chunk> serials;
+    std::vector<const uint8_t*> messages;
+    std::vector<size_t> sizes;
+    serials.reserve(count);
+    messages.reserve(count);
+    sizes.reserve(count);
+
+    for (const auto& tx: transactions)
+    {
+        serials.push_back(tx.to_data());
+        messages.push_back(serials.back().data());
+        sizes.push_back(serials.back().size());
+    }
+
+    hash_list out(count);
+    hash(out.data(), messages.data(), sizes.data(), count);
+    return out;
+}
+
+hash_digest hash_batch::merkle_root(hash_list hashes) const
+{
+    if (hashes.empty())
+        return null_hash;
+
+    // Each level is hashed in place as one batch of 64 byte node pairs. This
+    // is safe as each pair is read before its (lower addressed) hash is set.
+    while (hashes.size() > 1)
+    {
+        if (hashes.size() % 2 != 0)
+            hashes.push_back(hashes.back());
+
+        const auto pairs = hashes.size() / 2;
+        hash(hashes.data(), hashes.front().data(), 2 * hash_size, pairs);
+        hashes.resize(pairs);
+    }
+
+    return hashes.front();
+}
+
+} // namespace node
+} // namespace libbitcoin
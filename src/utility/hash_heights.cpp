@@ -0,0 +1,371 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/hash_heights.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+// Index slots hold the entry position plus one, so zero is vacant.
+static constexpr uint32_t vacant = 0;
+static constexpr size_t not_found = max_size_t;
+static constexpr size_t minimum_capacity = 16;
+
+hash_heights::hash_heights()
+  : first_(0), live_(0), requested_(0), indexed_(0)
+{
+}
+
+bool hash_heights::empty() const
+{
+    return live_ == 0;
+}
+
+size_t hash_heights::size() const
+{
+    return live_;
+}
+
+size_t hash_heights::requested() const
+{
+    return requested_;
+}
+
+bool hash_heights::front(hash_digest& out_hash, size_t& out_height,
+    bool& out_requested) const
+{
+    // The first position is kept at the lowest live entry.
+    if (live_ == 0)
+        return false;
+
+    const auto& entry = entries_[first_];
+    out_hash = entry.hash;
+    out_height = entry.height;
+    out_requested = entry.requested;
+    return true;
+}
+
+void hash_heights::clear()
+{
+    entries_.clear();
+    index_.clear();
+    first_ = 0;
+    live_ = 0;
+    requested_ = 0;
+    indexed_ = 0;
+}
+
+void hash_heights::insert(const hash_digest& hash, size_t height)
+{
+    // Keep the index at most half full, including erased entries.
+    if (2 * (indexed_ + 1) > index_.size())
+        compact();
+
+    // Hashes are allocated in height order, so this is the dominant path.
+    if (entries_.empty() || entries_.back().height < height)
+    {
+        append(hash, height);
+        index(entries_.size() - 1);
+        return;
+    }
+
+    // A rescued or rejected hash usually precedes all present heights, and
+    // then takes the erased position below the first live entry.
+    if (first_ > 0 && height < entries_[first_].height)
+    {
+        entries_[--first_] = { hash, height, true, false };
+        ++live_;
+        index(first_);
+        return;
+    }
+
+    // Otherwise the entry is placed at its height, and the index positions
+    // of the entries above it are shifted rather than rebuilt.
+    const auto below = [](const entry& value, size_t height)
+    {
+        return value.height < height;
+    };
+
+    const auto it = std::lower_bound(entries_.begin() + first_,
+        entries_.end(), height, below);
+    const auto position = static_cast<size_t>(it - entries_.begin());
+    entries_.insert(it, { hash, height, true, false });
+    ++live_;
+
+    for (auto& slot: index_)
+        if (slot != vacant && slot > position)
+            ++slot;
+
+    index(position);
+}
+
+void hash_heights::merge(const hash_heights& other)
+{
+    auto ordered = true;
+    const auto start = entries_.size();
+
+    for (auto position = other.first_; position < other.entries_.size();
+        ++position)
+    {
+        const auto& entry = other.entries_[position];
+
+        if (entry.live)
+            ordered = append(entry.hash, entry.height) && ordered;
+    }
+
+    settle(start, ordered);
+}
+
+bool hash_heights::erase(const hash_digest& hash, size_t& out_height)
+{
+    const auto position = find(hash);
+
+    if (position == not_found)
+        return false;
+
+    auto& entry = entries_[position];
+    out_height = entry.height;
+    entry.live = false;
+
+    if (entry.requested)
+        --requested_;
+
+    if (--live_ == 0)
+    {
+        clear();
+        return true;
+    }
+
+    // Blocks tend to arrive in height order, leaving no interior holes.
+    while (first_ < entries_.size() && !entries_[first_].live)
+        ++first_;
+
+    return true;
+}
+
+void hash_heights::request(size_t count, hash_list& out, size_t ceiling)
+{
+    // Requested entries are mostly a prefix bounded by the request window.
+    for (auto position = first_; position < entries_.size() && count > 0;
+        ++position)
+    {
+        auto& entry = entries_[position];
+
+        if (entry.height > ceiling)
+            break;
+
+        if (!entry.live || entry.requested)
+            continue;
+
+        out.push_back(entry.hash);
+        entry.requested = true;
+        ++requested_;
+        --count;
+    }
+}
+
+void hash_heights::reset_requests()
+{
+    for (auto position = first_; position < entries_.size(); ++position)
+        entries_[position].requested = false;
+
+    requested_ = 0;
+}
+
+void hash_heights::move_front(hash_heights& other, size_t count)
+{
+    auto ordered = true;
+    const auto start = other.entries_.size();
+
+    for (; first_ < entries_.size() && count > 0; ++first_)
+    {
+        auto& entry = entries_[first_];
+
+        if (!entry.live)
+            continue;
+
+        if (entry.requested)
+            --requested_;
+
+        ordered = other.append(entry.hash, entry.height) && ordered;
+        entry.live = false;
+        --live_;
+        --count;
+    }
+
+    // The other set is sorted and indexed once for the move.
+    other.settle(start, ordered);
+
+    if (live_ == 0)
+    {
+        clear();
+        return;
+    }
+
+    // Keep the first position at the lowest live entry.
+    while (!entries_[first_].live)
+        ++first_;
+}
+
+void hash_heights::move_back(hash_heights& other, size_t count)
+{
+    size_t moved = 0;
+    auto ordered = true;
+    auto position = entries_.size();
+    const auto start = other.entries_.size();
+
+    // Find the lowest position of the count highest unrequested entries.
+    for (auto remaining = count; position > first_ && remaining > 0;)
+    {
+        const auto& entry = entries_[--position];
+
+        if (entry.live && !entry.requested)
+            --remaining;
+    }
+
+    // Append in height order, so an empty other set is not resorted.
+    for (; position < entries_.size(); ++position)
+    {
+        auto& entry = entries_[position];
+
+        if (!entry.live || entry.requested)
+            continue;
+
+        ordered = other.append(entry.hash, entry.height) && ordered;
+        entry.live = false;
+        --live_;
+        ++moved;
+    }
+
+    // The other set is sorted and indexed once for the move.
+    other.settle(start, ordered);
+
+    if (live_ == 0)
+        clear();
+    else if (moved > 0)
+        compact();
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+bool hash_heights::append(const hash_digest& hash, size_t height)
+{
+    const auto ordered = entries_.empty() || entries_.back().height < height;
+    entries_.push_back({ hash, height, true, false });
+    ++live_;
+    return ordered;
+}
+
+void hash_heights::settle(size_t start, bool ordered)
+{
+    const auto appended = entries_.size() - start;
+
+    if (ordered && 2 * (indexed_ + appended) <= index_.size())
+    {
+        for (auto position = start; position < entries_.size(); ++position)
+            index(position);
+
+        return;
+    }
+
+    const auto lesser = [](const entry& left, const entry& right)
+    {
+        return left.height < right.height;
+    };
+
+    if (!ordered)
+        std::stable_sort(entries_.begin() + first_, entries_.end(), lesser);
+
+    compact();
+}
+
+size_t hash_heights::bucket(const hash_digest& hash) const
+{
+    // Block hashes are uniformly distributed, so any word suffices.
+    uint64_t value;
+    std::memcpy(&value, hash.data(), sizeof(value));
+    return static_cast<size_t>(value) & (index_.size() - 1);
+}
+
+size_t hash_heights::find(const hash_digest& hash) const
+{
+    if (index_.empty())
+        return not_found;
+
+    const auto mask = index_.size() - 1;
+
+    for (auto slot = bucket(hash); index_[slot] != vacant;
+        slot = (slot + 1) & mask)
+    {
+        const auto position = index_[slot] - 1u;
+        const auto& entry = entries_[position];
+
+        // Erased entries remain in the probe sequence until compaction.
+        if (entry.live && entry.hash == hash)
+            return position;
+    }
+
+    return not_found;
+}
+
+void hash_heights::index(size_t position)
+{
+    const auto mask = index_.size() - 1;
+    auto slot = bucket(entries_[position].hash);
+
+    while (index_[slot] != vacant)
+        slot = (slot + 1) & mask;
+
+    index_[slot] = static_cast<uint32_t>(position + 1u);
+    ++indexed_;
+}
+
+void hash_heights::compact()
+{
+    const auto dead = [](const entry& value)
+    {
+        return !value.live;
+    };
+
+    entries_.erase(entries_.begin(), entries_.begin() + first_);
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(), dead),
+        entries_.end());
+    first_ = 0;
+
+    // Size the index to a quarter load, leaving room to grow before rebuild.
+    auto capacity = minimum_capacity;
+
+    while (capacity < 4 * (entries_.size() + 1))
+        capacity *= 2;
+
+    index_.assign(capacity, vacant);
+    indexed_ = 0;
+
+    for (size_t position = 0; position < entries_.size(); ++position)
+        index(position);
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -23,6 +23,7 @@
 #include <utility>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/hash_batch.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -30,15 +31,21 @@ namespace node {
 using namespace bc::chain;
 using namespace bc::config;
 
+// The number of validated hashes held before they are stored.
+static constexpr size_t chunk_size = max_get_headers;
+
 // Locking is optimized for a single intended caller.
 header_list::header_list(size_t slot, const checkpoint& start,
-    const checkpoint& stop)
-  : height_(safe_add(start.height(), size_t(1))),
+    const checkpoint& stop, check_list& hashes)
+  : hashes_(hashes),
+    last_(start.hash()),
+    count_(0),
+    height_(safe_add(start.height(), size_t(1))),
     start_(start),
     stop_(stop),
     slot_(slot)
 {
-    list_.reserve(safe_subtract(stop.height(), start.height()));
+    list_.reserve(chunk_size + max_get_headers);
 }
 
 bool header_list::complete() const
@@ -67,7 +74,7 @@ hash_digest header_list::previous_hash() const
     // Critical Section.
     shared_lock lock(mutex_);
 
-    return list_.empty() ? start_.hash() : list_.back().hash();
+    return last_;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -78,7 +85,7 @@ size_t header_list::previous_height() const
     shared_lock lock(mutex_);
 
     // This addition is safe.
-    return start_.height() + list_.size();
+    return start_.height() + count_;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -87,96 +94,123 @@ const hash_digest& header_list::stop_hash() const
     return stop_.hash();
 }
 
-// This is not thread safe, call only after complete.
-const chain::header::list& header_list::headers() const
-{
-    return list_;
-}
-
-bool header_list::merge(headers_const_ptr message)
+bool header_list::merge(headers_const_ptr message, bool& overtaken)
 {
+    static const hash_batch hasher;
     const auto& headers = message->elements();
 
+    // The message is hashed as one batch, outside of the critical section.
+    const auto hashes = hasher.hash(headers);
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section.
     unique_lock lock(mutex_);
 
+    // Another peer merged this range first, which is not a failure.
+    overtaken = !headers.empty() &&
+        headers.front().previous_block_hash() != last_;
+
+    if (overtaken)
+        return true;
+
     const auto count = std::min(remaining(), headers.size());
-    const auto end = headers.begin() + count;
+    const auto pending = list_.size();
+    auto height = safe_add(start_.height(), count_);
+    auto previous = last_;
 
-    for (auto it = headers.begin(); it != end; ++it)
+    for (size_t index = 0; index < count; ++index)
     {
-        const auto& header = *it;
+        const auto& header = headers[index];
+        const auto& hash = hashes[index];
 
-        if (!link(header) || !check(header) || !accept(header))
+        if (!link(header, previous) || !check(header, hash))
         {
-            list_.clear();
+            // Discard the message, retaining previously merged headers.
+            list_.resize(pending);
             return false;
         }
 
-        list_.push_back(header);
+        if (!accept(hash, ++height))
+        {
+            // The branch does not reach the stop checkpoint, discard it all.
+            reset();
+            return false;
+        }
+
+        previous = hash;
+        list_.push_back(hash);
     }
 
+    count_ += count;
+    last_ = previous;
+
+    if (list_.size() >= chunk_size || remaining() == 0)
+        flush();
+
     return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
-////checkpoint::list header_list::to_checkpoints() const
-////{
-////    ///////////////////////////////////////////////////////////////////////////
-////    // Critical Section.
-////    shared_lock lock(mutex_);
-////
-////    if (!complete() || list_.empty())
-////        return{};
-////
-////    checkpoint::list out;
-////    out.reserve(list_.size());
-////    auto height = start_.height();
-////
-////    // The height is safe from overflow.
-////    for (const auto& header: list_)
-////        out.emplace_back(header.hash(), height++);
-////
-////    return out;
-////    ///////////////////////////////////////////////////////////////////////////
-////}
-
 // private
 //-----------------------------------------------------------------------------
 
 size_t header_list::remaining() const
 {
     // This difference is safe from underflow.
-    return list_.capacity() - list_.size();
+    return (stop_.height() - start_.height()) - count_;
+}
+
+// Block sync starts only once all slots are complete, so hashes stored from a
+// branch that is later discarded are overwritten before they are used.
+void header_list::flush()
+{
+    // This difference is safe from underflow.
+    auto height = height_ + count_ - list_.size();
+
+    for (auto& hash: list_)
+        hashes_.enqueue(std::move(hash), height++);
+
+    list_.clear();
 }
 
-bool header_list::link(const chain::header& header) const
+void header_list::reset()
 {
-    if (list_.empty())
-        return header.previous_block_hash() == start_.hash();
+    list_.clear();
+    last_ = start_.hash();
+    count_ = 0;
+}
 
-    // Avoid copying and temporary reference assignment.
-    return header.previous_block_hash() == list_.back().hash();
+bool header_list::link(const chain::header& header,
+    const hash_digest& previous) const
+{
+    return header.previous_block_hash() == previous;
 }
 
-bool header_list::check(const header& header) const
+// This is header.check(retarget), using the batch hash of the header.
+bool header_list::check(const header& header, const hash_digest& hash) const
 {
-    // This is a hack for successful compile - this is dead code.
-    static const auto retarget = true;
+    static const uint256_t limit(compact{ retarget_proof_of_work_limit });
+    const auto bits = compact(header.bits());
+
+    if (bits.is_overflowed())
+        return false;
+
+    uint256_t target(bits);
+
+    if (target < 1 || target > limit || to_uint256(hash) > target)
+        return false;
 
-    // This validates is_valid_proof_of_work and is_valid_time_stamp.
-    return !header.check(retarget);
+    return header.is_valid_time_stamp();
 }
 
-bool header_list::accept(const header& header) const
+bool header_list::accept(const hash_digest& hash, size_t height) const
 {
     //// Parallel header download precludes validation of minimum_version,
     //// work_required and median_time_past, however checkpoints are verified.
     ////return !header.accept(...);
 
     // Verify last checkpoint.
-    return remaining() > 1 || header.hash() == stop_.hash();
+    return height != stop_.height() || hash == stop_.hash();
 }
 
 } // namespace node
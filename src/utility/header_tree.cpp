@@ -0,0 +1,362 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/header_tree.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <unordered_set>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/utility/hash_batch.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+
+header_tree::header_tree(size_t depth, size_t maximum, size_t peer_maximum,
+    bool bounded)
+  : depth_(depth),
+    maximum_(maximum),
+    peer_maximum_(peer_maximum),
+    bounded_(bounded),
+    top_(null_hash),
+    top_height_(0)
+{
+}
+
+size_t header_tree::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_tree::anchor(const hash_digest& hash, size_t height)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    entries_.clear();
+    tips_.clear();
+    owned_.clear();
+    entries_.emplace(hash, entry{ null_hash, height, 0, 0, true, false, 0 });
+    top_ = hash;
+    top_height_ = height;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_tree::connect(const header& header, size_t height)
+{
+    const auto hash = header.hash();
+    const auto& previous = header.previous_block_hash();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto parent = entries_.find(previous);
+
+    // A reorganization below the tree leaves nothing to link to.
+    if (parent == entries_.end())
+    {
+        entries_.clear();
+        tips_.clear();
+        owned_.clear();
+        entries_.emplace(hash,
+            entry{ null_hash, height, 0, header.bits(), true, false, 0 });
+    }
+    else
+    {
+        const auto work = parent->second.work + header.proof();
+        const auto it = entries_.find(hash);
+
+        // A header of the chain no longer counts against its peer.
+        if (it != entries_.end())
+            erase(it);
+
+        entries_.emplace(hash,
+            entry{ previous, height, work, header.bits(), true, false, 0 });
+    }
+
+    top_ = hash;
+    top_height_ = height;
+    prune();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_tree::disconnect(const hash_digest& hash)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto it = entries_.find(hash);
+
+    if (it != entries_.end())
+        it->second.chain = false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+header_tree::status header_tree::add(uint64_t peer,
+    const header::list& headers, hash_list& out_fetch)
+{
+    if (headers.empty())
+        return status::accepted;
+
+    static const hash_batch hasher;
+    const auto hashes = hasher.hash(headers);
+
+    // Proof of work is checked before any header is linked.
+    for (size_t index = 0; index < headers.size(); ++index)
+        if (!check(headers[index], hashes[index]))
+            return status::invalid;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto added = static_cast<size_t>(std::count_if(hashes.begin(),
+        hashes.end(), [this](const hash_digest& hash)
+        {
+            return entries_.count(hash) == 0;
+        }));
+
+    const auto full = [&]()
+    {
+        return entries_.size() + added > maximum_ ||
+            owned(peer) + added > peer_maximum_;
+    };
+
+    if (full())
+    {
+        evict();
+
+        if (full())
+            return status::saturated;
+    }
+
+    const auto parent = entries_.find(headers.front().previous_block_hash());
+
+    if (parent == entries_.end())
+        return status::orphan;
+
+    auto bits = parent->second.bits;
+
+    // A branch of cheap headers cannot be grown from a costly parent.
+    for (const auto& header: headers)
+    {
+        if (!step(header.bits(), bits))
+            return status::invalid;
+
+        bits = header.bits();
+    }
+
+    auto height = parent->second.height;
+    auto work = parent->second.work;
+
+    // The headers are sequential, so each links to its predecessor.
+    for (size_t index = 0; index < headers.size(); ++index)
+    {
+        const auto& header = headers[index];
+        ++height;
+        work += header.proof();
+
+        if (entries_.emplace(hashes[index], entry{ header.previous_block_hash(),
+            height, work, header.bits(), false, true, peer }).second)
+            ++owned_[peer];
+    }
+
+    const auto& tip = hashes.back();
+    const auto best = tips_.find(peer);
+
+    // The tip of a peer is only replaced by one of more work.
+    if (best == tips_.end())
+    {
+        tips_.emplace(peer, tip);
+    }
+    else
+    {
+        const auto prior = entries_.find(best->second);
+
+        if (prior == entries_.end() || prior->second.work < work)
+            best->second = tip;
+    }
+
+    // Blocks are only fetched for a branch of more work than the chain.
+    const auto top = entries_.find(top_);
+
+    if (top == entries_.end() || work > top->second.work)
+        branch(tip, out_fetch);
+
+    return status::accepted;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_tree::tip(uint64_t peer, hash_digest& out_hash,
+    size_t& out_height) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto best = tips_.find(peer);
+
+    if (best == tips_.end())
+        return false;
+
+    const auto it = entries_.find(best->second);
+
+    if (it == entries_.end())
+        return false;
+
+    out_hash = best->second;
+    out_height = it->second.height;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_tree::remove(uint64_t peer)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    tips_.erase(peer);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+// This is header.check(retarget), using the batch hash of the header.
+bool header_tree::check(const header& header, const hash_digest& hash)
+{
+    static const uint256_t limit(compact{ retarget_proof_of_work_limit });
+    const auto bits = compact(header.bits());
+
+    if (bits.is_overflowed())
+        return false;
+
+    uint256_t target(bits);
+
+    if (target < 1 || target > limit || to_uint256(hash) > target)
+        return false;
+
+    return header.is_valid_time_stamp();
+}
+
+// The bits of the anchor are unknown, so its children are not bounded.
+bool header_tree::step(uint32_t bits, uint32_t parent) const
+{
+    if (!bounded_ || parent == 0)
+        return true;
+
+    const uint256_t maximum(compact{ parent });
+    return uint256_t(compact{ bits }) <= maximum * retargeting_factor;
+}
+
+size_t header_tree::owned(uint64_t peer) const
+{
+    const auto count = owned_.find(peer);
+    return count == owned_.end() ? 0 : count->second;
+}
+
+header_tree::entries::iterator header_tree::erase(entries::iterator it)
+{
+    if (it->second.owned)
+    {
+        const auto count = owned_.find(it->second.peer);
+
+        if (count != owned_.end() && --count->second == 0)
+            owned_.erase(count);
+    }
+
+    return entries_.erase(it);
+}
+
+// Only a branch with a header of more work than the chain top is fetched, so
+// the headers below it are retained and all other branches are dropped.
+void header_tree::evict()
+{
+    const auto top = entries_.find(top_);
+    const uint256_t threshold = top == entries_.end() ? 0 : top->second.work;
+    std::unordered_set<hash_digest> retained;
+
+    for (const auto& item: entries_)
+    {
+        if (item.second.chain || item.second.work <= threshold)
+            continue;
+
+        // Walk down to the chain, stopping at an already retained header.
+        for (auto it = entries_.find(item.first); it != entries_.end() &&
+            !it->second.chain && retained.insert(it->first).second;
+            it = entries_.find(it->second.previous));
+    }
+
+    for (auto it = entries_.begin(); it != entries_.end();)
+        it = it->second.chain || retained.count(it->first) != 0 ?
+            std::next(it) : erase(it);
+
+    for (auto it = tips_.begin(); it != tips_.end();)
+        it = entries_.count(it->second) == 0 ? tips_.erase(it) : std::next(it);
+}
+
+bool header_tree::branch(const hash_digest& tip, hash_list& out) const
+{
+    const auto start = out.size();
+
+    for (auto it = entries_.find(tip); it != entries_.end();
+        it = entries_.find(it->second.previous))
+    {
+        if (it->second.chain)
+        {
+            std::reverse(out.begin() + start, out.end());
+            return true;
+        }
+
+        out.push_back(it->first);
+    }
+
+    // The branch forks below the tree, so its work is unknown.
+    out.resize(start);
+    return false;
+}
+
+void header_tree::prune()
+{
+    if (top_height_ <= depth_)
+        return;
+
+    const auto floor = top_height_ - depth_;
+
+    for (auto it = entries_.begin(); it != entries_.end();)
+        it = it->second.height < floor ? erase(it) : std::next(it);
+
+    for (auto it = tips_.begin(); it != tips_.end();)
+        it = entries_.count(it->second) == 0 ? tips_.erase(it) : std::next(it);
+}
+
+} // namespace node
+} // namespace libbitcoin
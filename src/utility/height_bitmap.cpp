@@ -0,0 +1,317 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/height_bitmap.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+#endif
+
+namespace libbitcoin {
+namespace node {
+
+// The bitmap file identifier and format version.
+static constexpr uint32_t bitmap_magic = 0x6d74686e;
+static constexpr uint32_t bitmap_version = 1;
+
+static constexpr size_t word_bits = 64;
+
+// The number of set bits, a single instruction where supported.
+static size_t popcount(uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<size_t>(__builtin_popcountll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<size_t>(__popcnt64(word));
+#else
+    size_t count = 0;
+    for (; word != 0; word &= word - 1)
+        ++count;
+    return count;
+#endif
+}
+
+// The position of the lowest set bit, the word must be nonzero.
+static size_t lowest(uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<size_t>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<size_t>(index);
+#else
+    size_t index = 0;
+    for (; (word & 1u) == 0; word >>= 1)
+        ++index;
+    return index;
+#endif
+}
+
+// The mask of the bits of the word at or below the height.
+static uint64_t through(size_t height)
+{
+    const auto bit = height % word_bits;
+    return bit == word_bits - 1 ? max_uint64 : (uint64_t(1) << (bit + 1)) - 1;
+}
+
+height_bitmap::height_bitmap(const boost::filesystem::path& file)
+  : file_(file), valid_(false), saved_(false)
+{
+}
+
+bool height_bitmap::valid() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return valid_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool height_bitmap::load(size_t top)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    words_.clear();
+    valid_ = false;
+    saved_ = false;
+
+    bc::ifstream file(file_.string(), std::ios::in | std::ios::binary);
+
+    if (file.fail())
+        return false;
+
+    istream_reader source(file);
+
+    if (source.read_4_bytes_little_endian() != bitmap_magic ||
+        source.read_4_bytes_little_endian() != bitmap_version)
+        return false;
+
+    const auto saved_top = source.read_8_bytes_little_endian();
+    const auto count = source.read_8_bytes_little_endian();
+
+    // Blocks stored or popped outside of the bitmap change the top.
+    if (!source || saved_top != top || count != top / word_bits + 1)
+        return false;
+
+    words_.resize(count);
+
+    for (auto& word: words_)
+        word = source.read_8_bytes_little_endian();
+
+    if (!source)
+    {
+        words_.clear();
+        return false;
+    }
+
+    valid_ = true;
+    saved_ = true;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The file is replaced by rename, so a failed write leaves no valid bitmap.
+bool height_bitmap::save(size_t top)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // Bits set by sync alone do not describe the rest of the store.
+    if (!valid_)
+        return false;
+
+    words_.resize(top / word_bits + 1, 0);
+
+    // Heights above the top are empty by definition.
+    words_.back() &= through(top);
+
+    auto temporary = file_;
+    temporary += ".tmp";
+
+    {
+        bc::ofstream file(temporary.string(),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (file.fail())
+            return false;
+
+        ostream_writer sink(file);
+        sink.write_4_bytes_little_endian(bitmap_magic);
+        sink.write_4_bytes_little_endian(bitmap_version);
+        sink.write_8_bytes_little_endian(top);
+        sink.write_8_bytes_little_endian(words_.size());
+
+        for (const auto word: words_)
+            sink.write_8_bytes_little_endian(word);
+
+        file.flush();
+
+        if (!sink || file.fail())
+            return false;
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(temporary, file_, ec);
+    saved_ = !ec;
+    return saved_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void height_bitmap::assign(const heights& gaps, size_t top)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    invalidate();
+    valid_ = true;
+    words_.assign(top / word_bits + 1, max_uint64);
+    words_.back() = through(top);
+
+    for (const auto height: gaps)
+        if (height <= top)
+            words_[height / word_bits] &=
+                ~(uint64_t(1) << (height % word_bits));
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void height_bitmap::set(size_t height)
+{
+    const auto index = height / word_bits;
+    const auto bit = uint64_t(1) << (height % word_bits);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (index >= words_.size())
+        words_.resize(index + 1, 0);
+
+    if ((words_[index] & bit) == 0)
+    {
+        invalidate();
+        words_[index] |= bit;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void height_bitmap::reset(size_t height)
+{
+    const auto index = height / word_bits;
+    const auto bit = uint64_t(1) << (height % word_bits);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (index < words_.size() && (words_[index] & bit) != 0)
+    {
+        invalidate();
+        words_[index] &= ~bit;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool height_bitmap::contains(size_t height) const
+{
+    const auto index = height / word_bits;
+    const auto bit = uint64_t(1) << (height % word_bits);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return index < words_.size() && (words_[index] & bit) != 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t height_bitmap::count() const
+{
+    size_t total = 0;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    for (const auto word: words_)
+        total += popcount(word);
+
+    return total;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Populated words are skipped whole, so the scan is dominated by memory
+// bandwidth over top / 64 words rather than by the number of heights.
+void height_bitmap::gaps(heights& out, size_t top) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto words = top / word_bits + 1;
+    size_t empty = 0;
+
+    // Size the output from a population count of the inverted words.
+    for (size_t index = 0; index < words; ++index)
+    {
+        const auto mask = index == words - 1 ? through(top) : max_uint64;
+        const auto word = index < words_.size() ? words_[index] : 0;
+        empty += popcount(~word & mask);
+    }
+
+    out.reserve(out.size() + empty);
+
+    for (size_t index = 0; index < words; ++index)
+    {
+        const auto mask = index == words - 1 ? through(top) : max_uint64;
+        const auto word = index < words_.size() ? words_[index] : 0;
+
+        for (auto missing = ~word & mask; missing != 0;
+            missing &= missing - 1)
+            out.push_back(index * word_bits + lowest(missing));
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+// Called under the exclusive lock. A crash after this rebuilds the bitmap.
+void height_bitmap::invalidate()
+{
+    if (!saved_)
+        return;
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(file_, ec);
+    saved_ = false;
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/import_queue.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+import_queue::import_queue(size_t capacity, size_t threads)
+  : pending_(0),
+    started_(false),
+    stopping_(false),
+    capacity_(capacity),
+    thread_count_(threads == 0 ? 1 : threads)
+{
+}
+
+import_queue::~import_queue()
+{
+    stop();
+}
+
+bool import_queue::start()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (started_)
+        return false;
+
+    started_ = true;
+    stopping_ = false;
+
+    for (size_t thread = 0; thread < thread_count_; ++thread)
+        threads_.emplace_back(&import_queue::run, this);
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void import_queue::stop()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    if (!started_ || stopping_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    stopping_ = true;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The threads drain the queue before they exit.
+    condition_.notify_all();
+
+    for (auto& thread: threads_)
+        thread.join();
+
+    threads_.clear();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    started_ = false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t import_queue::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return pending_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool import_queue::full() const
+{
+    return size() >= capacity_;
+}
+
+void import_queue::push(job&& handler)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    // Stopping threads may already have drained the queue and exited.
+    if (!started_ || stopping_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        handler();
+        return;
+    }
+
+    jobs_.push_back(std::move(handler));
+    ++pending_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    condition_.notify_one();
+}
+
+bool import_queue::try_push(job&& handler)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    // The check and the queueing are atomic with respect to stop.
+    if (!started_ || stopping_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    jobs_.push_back(std::move(handler));
+    ++pending_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    condition_.notify_one();
+    return true;
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+void import_queue::run()
+{
+    while (true)
+    {
+        job handler;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        condition_.wait(lock, [this]()
+        {
+            return stopping_ || !jobs_.empty();
+        });
+
+        // Stop only once all queued jobs have run.
+        if (jobs_.empty())
+            return;
+
+        handler = std::move(jobs_.front());
+        jobs_.pop_front();
+
+        lock.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        handler();
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        lock.lock();
+
+        // Count the job until it completes, so full reflects store backlog.
+        --pending_;
+        ///////////////////////////////////////////////////////////////////////
+    }
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/locator_cache.hpp>
+
+#include <bitcoin/blockchain.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::blockchain;
+using namespace bc::chain;
+
+bool locator_cache::empty() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return hashes_.empty();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void locator_cache::clear()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    hashes_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Every height but the recent ones is a fixed distance below the top, so all
+// move with the top. This reads about thirty hashes, once per new top.
+bool locator_cache::rebuild(const fast_chain& chain)
+{
+    size_t top;
+    hash_digest hash;
+    hash_list hashes;
+
+    if (!chain.get_last_height(top))
+    {
+        clear();
+        return false;
+    }
+
+    const auto heights = block::locator_heights(top);
+    hashes.reserve(heights.size());
+
+    for (const auto height: heights)
+    {
+        if (!chain.get_block_hash(hash, height))
+        {
+            clear();
+            return false;
+        }
+
+        hashes.push_back(hash);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    hashes_.swap(hashes);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+hash_list locator_cache::hashes() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return hashes_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/prevout_prefetch.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+
+// The number of lookups in one job, amortizing the queue over many reads.
+static constexpr size_t batch_size = 64;
+
+prevout_prefetch::prevout_prefetch(lookup&& handler, size_t capacity,
+    size_t threads)
+  : lookup_(std::move(handler)),
+    queue_(capacity, threads)
+{
+}
+
+bool prevout_prefetch::start()
+{
+    return queue_.start();
+}
+
+void prevout_prefetch::stop()
+{
+    queue_.stop();
+}
+
+size_t prevout_prefetch::prefetch(const transaction::list& transactions)
+{
+    size_t queued = 0;
+    output_point::list batch;
+    batch.reserve(batch_size);
+
+    for (const auto& tx: transactions)
+    {
+        // Missing transactions of a compact block are not yet valid.
+        if (!tx.is_valid() || tx.is_coinbase())
+            continue;
+
+        for (const auto& input: tx.inputs())
+        {
+            batch.push_back(input.previous_output());
+
+            if (batch.size() < batch_size)
+                continue;
+
+            if (!push(std::move(batch)))
+                return queued;
+
+            queued += batch_size;
+            batch = output_point::list{};
+            batch.reserve(batch_size);
+        }
+    }
+
+    const auto remainder = batch.size();
+
+    if (remainder > 0 && push(std::move(batch)))
+        queued += remainder;
+
+    return queued;
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+bool prevout_prefetch::push(output_point::list&& batch)
+{
+    // Prefetching is advisory, so it yields to a backlog rather than grow.
+    if (queue_.full())
+        return false;
+
+    const auto points = std::make_shared<output_point::list>(std::move(batch));
+
+    // A stopped queue would run the job on the caller, so it is dropped.
+    return queue_.try_push([this, points]()
+    {
+        for (const auto& point: *points)
+            lookup_(point);
+    });
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/rate_history.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+rate_history::rate_history(size_t capacity)
+  : records_(capacity == 0 ? 1 : capacity),
+    head_(0),
+    size_(0),
+    events_(0),
+    database_(0)
+{
+}
+
+bool rate_history::empty() const
+{
+    return size_ == 0;
+}
+
+size_t rate_history::size() const
+{
+    return size_;
+}
+
+size_t rate_history::events() const
+{
+    return events_;
+}
+
+uint64_t rate_history::database() const
+{
+    return database_;
+}
+
+rate_history::time_point rate_history::front() const
+{
+    return records_[head_].time;
+}
+
+void rate_history::clear()
+{
+    head_ = 0;
+    size_ = 0;
+    events_ = 0;
+    database_ = 0;
+}
+
+bool rate_history::expire(const time_point& start)
+{
+    const auto prior = size_;
+
+    // Records are appended in time order, so expiry is from the head.
+    while (size_ > 0 && records_[head_].time < start)
+        pop();
+
+    return size_ < prior;
+}
+
+void rate_history::push(size_t events, uint64_t database,
+    const time_point& time)
+{
+    if (size_ == records_.size())
+        pop();
+
+    auto& record = records_[(head_ + size_) % records_.size()];
+    record.events = events;
+    record.database = database;
+    record.time = time;
+    ++size_;
+
+    BITCOIN_ASSERT(events_ <= max_size_t - events);
+    events_ += events;
+    BITCOIN_ASSERT(database_ <= max_uint64 - database);
+    database_ += database;
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+void rate_history::pop()
+{
+    const auto& record = records_[head_];
+    events_ -= record.events;
+    database_ -= record.database;
+    head_ = (head_ + 1) % records_.size();
+    --size_;
+
+    // Rewind to the start of the ring when empty.
+    if (size_ == 0)
+        head_ = 0;
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/reorder_buffer.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+reorder_buffer::reorder_buffer(size_t next_height, size_t capacity)
+  : next_(next_height), bytes_(0), capacity_(capacity)
+{
+}
+
+size_t reorder_buffer::next() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return next_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t reorder_buffer::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return blocks_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t reorder_buffer::bytes() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return bytes_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reorder_buffer::saturated() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return bytes_ >= capacity_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reorder_buffer::push(block_const_ptr block, size_t height)
+{
+    const auto size = block->serialized_size();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // A block below the next height has already been released.
+    if (height < next_)
+        return false;
+
+    if (!blocks_.emplace(height, entry{ block, size }).second)
+        return false;
+
+    bytes_ += size;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+block_const_ptr reorder_buffer::pop(size_t& out_height)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // The map is ordered, so the next block is first if present.
+    const auto it = blocks_.begin();
+
+    if (it == blocks_.end() || it->first != next_)
+        return nullptr;
+
+    const auto block = it->second.block;
+    bytes_ -= it->second.size;
+    blocks_.erase(it);
+    out_height = next_++;
+    return block;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reorder_buffer::restore(block_const_ptr block, size_t height)
+{
+    const auto size = block->serialized_size();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // Only the last released block is restored, so no gap is left below.
+    if (next_ == 0 || height != next_ - 1)
+        return false;
+
+    if (!blocks_.emplace(height, entry{ block, size }).second)
+        return false;
+
+    bytes_ += size;
+    next_ = height;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
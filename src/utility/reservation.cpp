@@ -18,6 +18,7 @@
  */
 #include <bitcoin/node/utility/reservation.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstddef>
@@ -46,17 +47,29 @@ static constexpr float multiple = 1.01f;
 // The minimum amount of block history to move the state from idle.
 static constexpr size_t minimum_history = 3;
 
+// The maximum amount of block history, beyond which the window shortens.
+static constexpr size_t maximum_history = 1024;
+
 // Simple conversion factor, since we trace in micro and report in seconds.
 static constexpr size_t micro_per_second = 1000 * 1000;
 
+// The number of mean block intervals without an arrival that is a stall.
+static constexpr double stall_multiple = 4.0;
+
+// The least stall timeout, so that fast rows are not rescued on jitter.
+static constexpr uint64_t minimum_stall = 500 * 1000;
+
 reservation::reservation(reservations& reservations, size_t slot,
-    uint32_t sync_timeout_seconds)
+    uint32_t sync_timeout_seconds, size_t window)
   : rate_({ true, 0, 0, 0 }),
+    summarized_(true),
+    history_(maximum_history),
     stopped_(false),
-    pending_(true),
-    partitioned_(false),
+    rejected_(false),
+    retired_(false),
     reservations_(reservations),
     slot_(slot),
+    window_(window),
     rate_window_(minimum_history * sync_timeout_seconds * micro_per_second)
 {
 }
@@ -72,14 +85,14 @@ size_t reservation::slot() const
     return slot_;
 }
 
-bool reservation::pending() const
+size_t reservation::requested() const
 {
-    return pending_;
-}
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
 
-void reservation::set_pending(bool value)
-{
-    pending_ = value;
+    return heights_.requested();
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 std::chrono::microseconds reservation::rate_window() const
@@ -102,36 +115,67 @@ void reservation::reset()
     clear_history();
 }
 
-// Shortcut for rate().idle call.
+// Shortcut for rate().idle call, does not block.
 bool reservation::idle() const
+{
+    return rate_.idle();
+}
+
+// Readers are not excluded, they retry over a concurrent store.
+void reservation::set_rate(performance&& rate)
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(rate_mutex_);
+    unique_lock lock(rate_mutex_);
+
+    // Summary updates are ordered as the rates they replace.
+    if (summarized_)
+        reservations_.update_rates(rate_.load(), rate);
 
-    return rate_.idle;
+    rate_.store(rate);
     ///////////////////////////////////////////////////////////////////////////
 }
 
-void reservation::set_rate(performance&& rate)
+// A removed row may still import its last blocks, which must not return it
+// to the summary of active rows.
+void reservation::withdraw_rate()
 {
+    static const performance idle{ true, 0, 0, 0 };
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(rate_mutex_);
 
-    rate_ = std::move(rate);
+    if (!summarized_)
+        return;
+
+    reservations_.update_rates(rate_.load(), idle);
+    summarized_ = false;
     ///////////////////////////////////////////////////////////////////////////
 }
 
-// Get a copy of the current rate.
+// Get a copy of the current rate, does not block.
 performance reservation::rate() const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    shared_lock lock(rate_mutex_);
+    return rate_.load();
+}
 
-    return rate_;
-    ///////////////////////////////////////////////////////////////////////////
+// An idle row has no rate, so it is allowed the rate window of one block.
+microseconds reservation::stall_timeout() const
+{
+    const auto limit = static_cast<uint64_t>(rate_window().count()) /
+        minimum_history;
+    const auto record = rate();
+
+    if (record.idle)
+        return microseconds(limit);
+
+    // The rate is in blocks per microsecond, zero if unmeasurable.
+    const auto interval = divide<double>(stall_multiple, record.total());
+    const auto bounded = interval == 0.0 ? limit :
+        static_cast<uint64_t>(std::min(interval, static_cast<double>(limit)));
+
+    return microseconds(std::max(bounded, minimum_stall));
 }
 
 // Ignore idleness here, called only from an active channel, avoiding a race.
@@ -183,15 +227,11 @@ void reservation::update_rate(size_t events, const microseconds& database)
     const auto end = now();
     const auto event_start = end - microseconds(database);
     const auto start = end - rate_window();
-    const auto history_count = history_.size();
-
-    // Remove expired entries from the head of the queue.
-    for (auto it = history_.begin(); it != history_.end() && it->time < start;
-        it = history_.erase(it));
 
-    const auto window_full = history_count > history_.size();
+    // Remove expired entries from the head of the ring.
+    const auto window_full = history_.expire(start);
     const auto event_cost = static_cast<uint64_t>(database.count());
-    history_.push_back({ events, event_cost, event_start });
+    history_.push(events, event_cost, event_start);
 
     // We can't set the rate until we have a period (two or more data points).
     if (history_.size() < minimum_history)
@@ -201,17 +241,12 @@ void reservation::update_rate(size_t events, const microseconds& database)
         return;
     }
 
-    // Summarize event count and database cost.
-    for (const auto& record: history_)
-    {
-        BITCOIN_ASSERT(rate.events <= max_size_t - record.events);
-        rate.events += record.events;
-        BITCOIN_ASSERT(rate.database <= max_uint64 - record.database);
-        rate.database += record.database;
-    }
+    // Event count and database cost are summarized as records come and go.
+    rate.events = history_.events();
+    rate.database = history_.database();
 
     // Calculate the duration of the rate window.
-    auto window = window_full ? rate_window() : (end - history_.front().time);
+    auto window = window_full ? rate_window() : (end - history_.front());
     auto count = duration_cast<microseconds>(window).count();
     rate.window = static_cast<uint64_t>(count);
 
@@ -252,6 +287,16 @@ size_t reservation::size() const
     ///////////////////////////////////////////////////////////////////////////
 }
 
+size_t reservation::unrequested() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
+
+    return heights_.size() - heights_.requested();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 bool reservation::stopped() const
 {
     // Critical Section (stop)
@@ -262,10 +307,12 @@ bool reservation::stopped() const
     ///////////////////////////////////////////////////////////////////////////
 }
 
-// Obtain and clear the outstanding blocks request.
+// Obtain the request to refill the window of blocks in flight.
 message::get_data reservation::request(bool new_channel)
 {
-    message::get_data packet;
+    hash_list hashes;
+    const auto ceiling = reservations_.request_ceiling();
+    const auto backlogged = reservations_.backlogged();
 
     // We are a new channel, clear history and rate data, next block starts.
     if (new_channel)
@@ -273,29 +320,35 @@ message::get_data reservation::request(bool new_channel)
 
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
+    hash_mutex_.lock();
 
-    if (!new_channel && !pending_)
-    {
-        hash_mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
-        return packet;
-    }
+    // Blocks requested by a preceding channel will not arrive.
+    if (new_channel)
+        heights_.reset_requests();
 
-    // Build get_blocks request message.
-    for (auto height = heights_.right.begin(); height != heights_.right.end();
-        ++height)
-    {
-        static const auto id = message::inventory::type_id::block;
-        packet.inventories().emplace_back(id, height->second);
-    }
+    const auto requested = heights_.requested();
+
+    // Request the lowest unrequested hashes, up to the window and ceiling.
+    // Refills pause while the store is backlogged.
+    if (requested < window_ && !backlogged)
+        heights_.request(window_ - requested, hashes, ceiling);
+
+    // The stall timer starts when blocks go in flight from none.
+    if (requested == 0 && !hashes.empty())
+        progress_ = now();
 
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    hash_mutex_.unlock_upgrade_and_lock();
-    pending_ = false;
     hash_mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
+    message::get_data packet;
+    static const auto id = message::inventory::type_id::block;
+    auto& inventories = packet.inventories();
+    inventories.reserve(hashes.size());
+
+    // Build get_blocks request message in height order.
+    for (const auto& hash: hashes)
+        inventories.emplace_back(id, hash);
+
     return packet;
 }
 
@@ -305,8 +358,53 @@ void reservation::insert(hash_digest&& hash, size_t height)
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(hash_mutex_);
 
-    pending_ = true;
-    heights_.insert({ std::move(hash), height });
+    heights_.insert(hash, height);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void reservation::insert(const hash_heights& hashes)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    heights_.merge(hashes);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A discarded hash does not count as progress.
+bool reservation::discard(const hash_digest& hash)
+{
+    size_t height;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    return heights_.erase(hash, height);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reservation::front(hash_digest& out_hash, size_t& out_height,
+    bool& out_requested) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
+
+    return heights_.front(out_hash, out_height, out_requested);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reservation::stalled() const
+{
+    const auto timeout = stall_timeout();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
+
+    return heights_.requested() > 0 && now() - progress_ > timeout;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -314,17 +412,75 @@ void reservation::import(block_const_ptr block)
 {
     size_t height;
     const auto hash = block->header().hash();
-    const auto encoded = encode_hash(hash);
 
     if (!find_height_and_erase(hash, height))
     {
         LOG_DEBUG(LOG_NODE)
             << "Ignoring unsolicited block (" << slot() << ") ["
-            << encoded << "]";
+            << encode_hash(hash) << "]";
+        return;
+    }
+
+    // A block requested from two rows is imported by the first arrival.
+    if (!reservations_.resolve(shared_from_this(), hash, height))
+    {
+        LOG_DEBUG(LOG_NODE)
+            << "Ignoring duplicate block #" << height << " (" << slot()
+            << ") [" << encode_hash(hash) << "]";
+        populate();
         return;
     }
 
+    // The block is checked on a worker and then stored on the store thread.
+    reservations_.check(shared_from_this(), block, height);
+    populate();
+}
+
+// Called on a check worker, the block will be requested again.
+void reservation::reject(block_const_ptr block, size_t height,
+    const code& ec)
+{
+    const auto hash = block->header().hash();
+
+    LOG_DEBUG(LOG_NODE)
+        << "Rejected invalid block #" << height << " (" << slot() << ") ["
+        << encode_hash(hash) << "] " << ec.message();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    rejected_ = true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reservation::toggle_rejected()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock_upgrade();
+
+    if (rejected_)
+    {
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+        hash_mutex_.unlock_upgrade_and_lock();
+        rejected_ = false;
+        hash_mutex_.unlock();
+        //---------------------------------------------------------------------
+        return true;
+    }
+
+    hash_mutex_.unlock_upgrade();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return false;
+}
+
+// Called on the store thread, in order of receipt across reservations.
+void reservation::store(block_const_ptr block, size_t height)
+{
     bool success;
+    const auto encoded = encode_hash(block->header().hash());
     const auto importer = [this, &block, &height, &success]()
     {
         success = reservations_.import(block, height);
@@ -345,17 +501,20 @@ void reservation::import(block_const_ptr block)
             << boost::format(formatter) % height % slot() % encoded %
             (record.total() * micro_per_second) % (record.ratio() * 100);
     }
+    else if (reservations_.failed())
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Failed to import block #" << height << " (" << slot() << ") ["
+            << encoded << "]";
+    }
     else
     {
-        // This could also result from a block import failure resulting from
-        // inserting at a height that is already populated, but that should be
-        // precluded by the implementation. This is the only other failure.
+        // Otherwise the block was already buffered or released, which should
+        // be precluded by duplicate resolution, or the store was stopped.
         LOG_DEBUG(LOG_NODE)
             << "Stopped before importing block (" << slot() << ") ["
             << encoded << "]";
     }
-
-    populate();
 }
 
 void reservation::populate()
@@ -368,7 +527,9 @@ void reservation::populate()
     {
         //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
         stop_mutex_.unlock_upgrade_and_lock();
-        stopped_ = !reservations_.populate(shared_from_this());
+
+        // A retired reservation stops once its blocks in flight are imported.
+        stopped_ = retired_ || !reservations_.populate(shared_from_this());
         stop_mutex_.unlock();
         //---------------------------------------------------------------------
         return;
@@ -378,71 +539,75 @@ void reservation::populate()
     ///////////////////////////////////////////////////////////////////////////
 }
 
-bool reservation::toggle_partitioned()
+// Blocks in flight are retained, so the channel is not interrupted.
+void reservation::retire(hash_heights& out_hashes)
 {
-    // Critical Section
+    // Critical Section (stop)
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
+    stop_mutex_.lock();
 
-    if (partitioned_)
-    {
-        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-        hash_mutex_.unlock_upgrade_and_lock();
-        partitioned_ = false;
-        pending_ = true;
-        hash_mutex_.unlock();
-        //---------------------------------------------------------------------
-        return true;
-    }
+    // Precludes repopulation and partition to this reservation.
+    retired_ = true;
 
-    hash_mutex_.unlock_upgrade();
+    // Critical Section (hash)
     ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock();
 
-    return false;
+    heights_.move_back(out_hashes, heights_.size());
+    const auto remaining = heights_.size();
+
+    hash_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Without blocks in flight the channel stops upon its next timer event.
+    if (remaining == 0)
+        stopped_ = true;
+
+    stop_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_DEBUG(LOG_NODE)
+        << "Retired slot (" << slot() << ") returning [" << out_hashes.size()
+        << "] blocks with [" << remaining << "] in flight.";
 }
 
-// Give the minimal row ~ half of our hashes, return false if minimal is empty.
+bool reservation::retired() const
+{
+    return retired_;
+}
+
+// Give the minimal row ~ half of our unrequested hashes, return false if
+// minimal is empty. Blocks in flight are never moved.
 bool reservation::partition(reservation::ptr minimal)
 {
     // This assumes that partition has been called under a table mutex.
     if (!minimal->empty())
         return true;
 
+    // Both rows may be inserted to by workers, so both hash locks are taken,
+    // in slot order to preclude deadlock between concurrent partitions.
+    const auto lower = slot() < minimal->slot();
+    auto& first = lower ? hash_mutex_ : minimal->hash_mutex_;
+    auto& second = lower ? minimal->hash_mutex_ : hash_mutex_;
+
     // Critical Section (hash)
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
+    first.lock();
+    second.lock();
 
     // This addition is safe.
-    // Take half of the maximal reservation, rounding up to get last entry.
-    const auto offset = (heights_.size() + 1u) / 2u;
-    auto it = heights_.right.begin();
-
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    hash_mutex_.unlock_upgrade_and_lock();
-
-    // TODO: move the range in a single command.
-    for (size_t index = 0; index < offset; ++index)
-    {
-        minimal->heights_.right.insert(std::move(*it));
-        it = heights_.right.erase(it);
-    }
-
-    partitioned_ = !heights_.empty();
-    const auto populated = !minimal->empty();
-    minimal->pending_ = populated;
-
-    if (!partitioned_)
-    {
-        // Critical Section (stop)
-        ///////////////////////////////////////////////////////////////////////
-        unique_lock lock(stop_mutex_);
-
-        // If the channel has been emptied it will not repopulate.
-        stopped_ = true;
-        ///////////////////////////////////////////////////////////////////////
-    }
-
-    hash_mutex_.unlock();
+    // Take the upper half of the unrequested hashes, rounding up to get the
+    // last entry. The only entry is kept, as stopping this row here would
+    // invert the stop and table lock order of populate.
+    const auto unrequested = heights_.size() - heights_.requested();
+    const auto half = (unrequested + 1u) / 2u;
+    const auto offset = half == heights_.size() ? 0u : half;
+
+    heights_.move_back(minimal->heights_, offset);
+    const auto populated = !minimal->heights_.empty();
+
+    second.unlock();
+    first.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
     if (populated)
@@ -458,26 +623,14 @@ bool reservation::find_height_and_erase(const hash_digest& hash,
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
-    hash_mutex_.lock_upgrade();
-
-    const auto it = heights_.left.find(hash);
+    unique_lock lock(hash_mutex_);
 
-    if (it == heights_.left.end())
-    {
-        hash_mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
+    if (!heights_.erase(hash, out_height))
         return false;
-    }
-
-    out_height = it->second;
-
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    hash_mutex_.unlock_upgrade_and_lock();
-    heights_.left.erase(it);
-    hash_mutex_.unlock();
-    ///////////////////////////////////////////////////////////////////////////
 
+    progress_ = now();
     return true;
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 } // namespace node
@@ -19,16 +19,19 @@
 #include <bitcoin/node/utility/reservations.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <memory>
-#include <numeric>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/hash_heights.hpp>
 #include <bitcoin/node/utility/performance.hpp>
+#include <bitcoin/node/utility/reorder_buffer.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
 
 namespace libbitcoin {
@@ -36,38 +39,274 @@ namespace node {
 
 using namespace bc::blockchain;
 using namespace bc::chain;
+using namespace bc::config;
 
-reservations::reservations(check_list& hashes, fast_chain& chain,
-    const settings& settings)
+// The number of rows started before regulation.
+static constexpr size_t initial_rows = 3;
+
+// The expected block bytes allocated to a row at a time, so that rows take
+// similar download work despite block sizes that grow with height.
+static constexpr uint64_t reservation_bytes = 64 * 1024 * 1024;
+
+// The number of received blocks awaiting storage at which requests pause.
+static constexpr size_t import_capacity = 256;
+
+// The number of received blocks awaiting checks at which requests pause.
+static constexpr size_t check_capacity = 256;
+
+// Context free block checks are spread across all cores.
+static size_t check_threads()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// The blocks inserted to a gap filling store between flushes, and the
+// buffered block bytes at which requests above the commit height pause. A
+// sequential store commits each block as it becomes contiguous. A crash loses
+// at most the unflushed blocks, which the sync journal requests on restart.
+
+// Relaxed sync defers flushes to large batches and buffers more blocks.
+static const reservations::durability relaxed
+{
+    2000, 512 * 1024 * 1024
+};
+
+// Strict sync flushes each block as it is inserted, as after sync.
+static const reservations::durability strict
+{
+    1, 256 * 1024 * 1024
+};
+
+// The height of the first block to commit to a sequential store.
+static size_t next_height(const fast_chain& chain)
+{
+    size_t top;
+    return chain.get_last_height(top) ? safe_add(top, size_t(1)) : 0;
+}
+
+reservations::reservations(check_list& hashes, height_bitmap& populated,
+    size_profile& sizes, fast_chain& chain, const settings& settings)
+  : reservations(hashes, populated, sizes, chain, settings,
+        sync_durability(settings))
+{
+}
+
+reservations::reservations(check_list& hashes, height_bitmap& populated,
+    size_profile& sizes, fast_chain& chain, const settings& settings,
+    const durability& durability)
   : hashes_(hashes),
+    populated_(populated),
+    profile_(sizes),
     max_request_(max_get_data),
+    failed_(false),
+    checking_(0),
     timeout_(settings.sync_timeout_seconds),
-    chain_(chain)
+    window_(std::max(std::min<size_t>(settings.sync_window, max_get_data),
+        size_t(1))),
+    maximum_rows_(settings.sync_peers),
+    durability_(durability),
+    chain_(chain),
+#if defined(BITPRIM_DB_LEGACY)
+    inserted_(0),
+#elif defined(BITPRIM_DB_NEW)
+    // The store connects blocks sequentially, so blocks from parallel slots
+    // are buffered and committed in height order.
+    buffer_(next_height(chain), durability_.reorder_bytes),
+#endif
+    rates_sequence_(0),
+    active_rows_(0),
+    rate_sum_(0),
+    rate_squares_(0),
+    throughput_(0),
+    ratio_sum_(0),
+    next_slot_(0),
+    queue_(import_capacity),
+    checks_(check_capacity, check_threads())
 {
-    initialize(std::min(settings.sync_peers, 3u));
+    // The regulator adds rows up to the maximum while throughput rises.
+    initialize(std::min(maximum_rows_, initial_rows));
+}
+
+const reservations::durability& reservations::sync_durability(
+    const settings& settings) {
+    // The profile lasts for the session, so the store returns to its strict
+    // configured durability once sync completes.
+    return settings.sync_relaxed ? relaxed : strict;
 }
 
 bool reservations::start() {
 #if defined(BITPRIM_DB_LEGACY)
-    return chain_.begin_insert();
+    if ( ! chain_.begin_insert()) {
+        return false;
+    }
+#elif ! defined(BITPRIM_DB_NEW)
+#error You must define BITPRIM_DB_LEGACY or BITPRIM_DB_NEW
+#endif
+
+    queue_.start();
+    checks_.start();
+    return true;
+}
+
+bool reservations::import(block_const_ptr block, size_t height) {
+#if defined(BITPRIM_DB_LEGACY)
+    {
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        shared_lock lock(commit_mutex_);
+
+        //#####################################################################
+        if (!chain_.insert(block, height))
+        {
+            failed_ = true;
+
+            LOG_ERROR(LOG_NODE)
+                << "Failed to store block #" << height << ".";
+            return false;
+        }
+        //#####################################################################
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    populated_.set(height);
+    profile_.record(height, block->serialized_size());
+    return checkpoint();
 #elif defined(BITPRIM_DB_NEW)
+    // Each importer commits what its block makes contiguous, so no buffered
+    // block is left behind by a concurrent commit.
+    if (!buffer_.push(block, height) || !commit())
+        return false;
+
+    profile_.record(height, block->serialized_size());
     return true;
 #else
 #error You must define BITPRIM_DB_LEGACY or BITPRIM_DB_NEW
 #endif
 }
 
-bool reservations::import(block_const_ptr block, size_t height) {
+bool reservations::failed() const {
+    return failed_;
+}
+
+size_t reservations::request_ceiling() const {
+#if defined(BITPRIM_DB_NEW)
+    // Once saturated only the block that unblocks the commit may be requested.
+    return buffer_.saturated() ? buffer_.next() : max_size_t;
+#else
+    return max_size_t;
+#endif
+}
+
+void reservations::check(reservation::ptr row, block_const_ptr block,
+    size_t height) {
+    // Counted until its hash is returned or its block is queued to store.
+    ++checking_;
+
+    checks_.push([this, row, block, height]() {
+        // The block hash is that of a verified header, so only the context
+        // free checks of the block body (merkle root, size, transactions)
+        // remain before storage. Accept and connect stay on the store path.
+        const auto ec = block->check();
+
+        if (ec) {
+            reject(row, block, height, ec);
+        } else {
+            enqueue(row, block, height);
+        }
+
+        --checking_;
+    });
+}
+
+bool reservations::drained() const {
+    return checking_ == 0 && hashes_.empty();
+}
+
+// The row may have stopped, retired or been removed since it received the
+// block, so the hash is reassigned to a live row or listed again.
+void reservations::reject(reservation::ptr row, block_const_ptr block,
+    size_t height, const code& ec) {
+    row->reject(block, height, ec);
+
+    hash_heights rejected;
+    rejected.insert(block->header().hash(), height);
+    reassign(rejected);
+}
+
+void reservations::enqueue(reservation::ptr row, block_const_ptr block,
+    size_t height) {
+    queue_.push([row, block, height]() {
+        row->store(block, height);
+    });
+}
+
+bool reservations::backlogged() const {
+    return checks_.full() || queue_.full();
+}
+
+#if defined(BITPRIM_DB_LEGACY)
+// The gap filling store flushes only as the flush lock guard clears, so the
+// guard is cycled to bound the blocks a crash would leave unflushed.
+bool reservations::checkpoint() {
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(commit_mutex_);
+
+    if (++inserted_ < durability_.batch_blocks) {
+        return true;
+    }
+
+    inserted_ = 0;
+
     //#########################################################################
-    return chain_.insert(block, height);
+    return chain_.end_insert() && chain_.begin_insert();
     //#########################################################################
+    ///////////////////////////////////////////////////////////////////////////
 }
+#endif // BITPRIM_DB_LEGACY
+
+#if defined(BITPRIM_DB_NEW)
+// The store has no multiple block commit, so each block is inserted as it
+// becomes contiguous. A failed block is restored to the buffer at the next
+// height, so no block above it commits and none is lost.
+bool reservations::commit() {
+    size_t height;
+    block_const_ptr block;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(commit_mutex_);
+
+    while ((block = buffer_.pop(height))) {
+        //#####################################################################
+        if ( ! chain_.insert(block, height)) {
+            buffer_.restore(block, height);
+            failed_ = true;
+
+            LOG_ERROR(LOG_NODE)
+                << "Failed to store block #" << height << ".";
+            return false;
+        }
+        //#####################################################################
+
+        populated_.set(height);
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+#endif // BITPRIM_DB_NEW
 
 bool reservations::stop() {
+    // Blocks received before completion are stored before the guard clears.
+    checks_.stop();
+    queue_.stop();
+
+    // Consolidate once, flushing the store.
 #if defined(BITPRIM_DB_LEGACY)
-    return chain_.end_insert();
+    return chain_.end_insert() && !failed_;
 #elif defined(BITPRIM_DB_NEW)
-    return true;
+    return commit() && !failed_;
 #else
 #error You must define BITPRIM_DB_LEGACY or BITPRIM_DB_NEW
 #endif
@@ -77,43 +316,100 @@ bool reservations::stop() {
 //-----------------------------------------------------------------------------
 
 // A statistical summary of block import rates.
-// This computation is not synchronized across rows because rates are cached.
+// The sums are maintained as row rates change, so this is constant time.
+// Readers never block the store thread, they retry over a concurrent update.
 reservations::rate_statistics reservations::rates() const
 {
-    // Copy row pointer table to prevent need for lock during iteration.
-    auto rows = table();
-    const auto idle = [](reservation::ptr row)
+    size_t active_rows;
+    double total;
+    double squares;
+    double throughput;
+    double ratios;
+    uint32_t before;
+    uint32_t after;
+
+    do
     {
-        return row->idle();
-    };
+        before = rates_sequence_.load(std::memory_order_acquire);
+        active_rows = active_rows_.load(std::memory_order_relaxed);
+        total = rate_sum_.load(std::memory_order_relaxed);
+        squares = rate_squares_.load(std::memory_order_relaxed);
+        throughput = throughput_.load(std::memory_order_relaxed);
+        ratios = ratio_sum_.load(std::memory_order_relaxed);
+
+        // Order the sum loads before the sequence reload.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = rates_sequence_.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1u) != 0);
 
-    // Remove idle rows from the table.
-    rows.erase(std::remove_if(rows.begin(), rows.end(), idle), rows.end());
-    const auto active_rows = rows.size();
+    const auto mean = divide<double>(total, active_rows);
+    const auto database_ratio = divide<double>(ratios, active_rows);
 
-    std::vector<double> rates(active_rows);
-    const auto normal_rate = [](reservation::ptr row)
+    // The variance is the mean of squares less the square of the mean.
+    const auto quotient = divide<double>(squares, active_rows) - mean * mean;
+    const auto standard_deviation = std::sqrt(std::max(quotient, 0.0));
+    return{ active_rows, mean, standard_deviation, throughput,
+        database_ratio };
+}
+
+// Idle rows are excluded from the summary.
+void reservations::update_rates(const performance& prior,
+    const performance& next)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(rates_mutex_);
+
+    // Updates are serialized here, so the sums are read without retry.
+    auto active_rows = active_rows_.load(std::memory_order_relaxed);
+    auto total = rate_sum_.load(std::memory_order_relaxed);
+    auto squares = rate_squares_.load(std::memory_order_relaxed);
+    auto throughput = throughput_.load(std::memory_order_relaxed);
+    auto ratios = ratio_sum_.load(std::memory_order_relaxed);
+
+    if (!prior.idle)
     {
-        return row->rate().normal();
-    };
+        const auto rate = prior.normal();
+        BITCOIN_ASSERT(active_rows > 0);
+        --active_rows;
+        total -= rate;
+        squares -= rate * rate;
+        throughput -= prior.total();
+        ratios -= prior.ratio();
+    }
 
-    // Convert to a rates table and sum.
-    std::transform(rows.begin(), rows.end(), rates.begin(), normal_rate);
-    const auto total = std::accumulate(rates.begin(), rates.end(), 0.0);
+    if (!next.idle)
+    {
+        const auto rate = next.normal();
+        ++active_rows;
+        total += rate;
+        squares += rate * rate;
+        throughput += next.total();
+        ratios += next.ratio();
+    }
 
-    // Calculate mean and sum of deviations.
-    const auto mean = divide<double>(total, active_rows);
-    const auto summary = [mean](double initial, double rate)
+    // Discard accumulated rounding error whenever all rows are idle.
+    if (active_rows == 0)
     {
-        const auto difference = mean - rate;
-        return initial + (difference * difference);
-    };
+        total = 0;
+        squares = 0;
+        throughput = 0;
+        ratios = 0;
+    }
+
+    const auto sequence = rates_sequence_.load(std::memory_order_relaxed);
+    rates_sequence_.store(sequence + 1u, std::memory_order_relaxed);
 
-    // Calculate the standard deviation in the rate deviations.
-    auto squares = std::accumulate(rates.begin(), rates.end(), 0.0, summary);
-    auto quotient = divide<double>(squares, active_rows);
-    auto standard_deviation = std::sqrt(quotient);
-    return{ active_rows, mean, standard_deviation };
+    // Order the odd sequence before the sum stores.
+    std::atomic_thread_fence(std::memory_order_release);
+    active_rows_.store(active_rows, std::memory_order_relaxed);
+    rate_sum_.store(total, std::memory_order_relaxed);
+    rate_squares_.store(squares, std::memory_order_relaxed);
+    throughput_.store(throughput, std::memory_order_relaxed);
+    ratio_sum_.store(ratios, std::memory_order_relaxed);
+
+    rates_sequence_.store(sequence + 2u, std::memory_order_release);
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 // Table methods.
@@ -129,7 +425,7 @@ reservation::list reservations::table() const
     ///////////////////////////////////////////////////////////////////////////
 }
 
-void reservations::remove(reservation::ptr row)
+bool reservations::remove(reservation::ptr row)
 {
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
@@ -141,14 +437,315 @@ void reservations::remove(reservation::ptr row)
     {
         mutex_.unlock_upgrade();
         //---------------------------------------------------------------------
-        return;
+        return false;
     }
 
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
     mutex_.unlock_upgrade_and_lock();
     table_.erase(it);
+
+    // A block awaiting checks may yet be rejected and listed again.
+    const auto emptied = table_.empty() && drained();
     mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
+
+    // The row may be active, and its later rate updates are ignored.
+    row->withdraw_rate();
+    forget(row);
+    return emptied;
+}
+
+reservation::ptr reservations::expand()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (table_.size() >= maximum_rows_)
+        return nullptr;
+
+    const auto row = std::make_shared<reservation>(*this, next_slot_,
+        timeout_, window_);
+
+    // Take from unallocated or allocated hashes, false if row is empty.
+    if (!reserve(row) && !partition(row))
+        return nullptr;
+
+    ++next_slot_;
+    table_.push_back(row);
+    return row;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool reservations::contract()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    // The stop lock of a populating row is held while it awaits this lock.
+    // Another live row must remain to reserve the returned hashes.
+    const auto slowest = find_live().size() < 2 ? nullptr : find_slowest();
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!slowest)
+        return false;
+
+    // The row remains in the table until its blocks in flight are imported.
+    // A populate in progress on this row completes before it is retired.
+    hash_heights returned;
+    slowest->retire(returned);
+    forget(slowest, returned);
+    reassign(returned);
+    return true;
+}
+
+// Retired heights are interleaved with those of the other rows and may
+// include the lowest uncommitted height. Returned to the hash list they would
+// wait for a row to empty, so they are spread over the live rows instead.
+void reservations::reassign(const hash_heights& hashes)
+{
+    if (hashes.empty())
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // A live row is not stopped and cannot stop while this lock is held, as
+    // it would first have to empty and then populate under this lock.
+    const auto rows = find_live();
+
+    if (rows.empty())
+    {
+        hashes.visit([this](const hash_digest& hash, size_t height)
+        {
+            hashes_.restore(hash_digest(hash), height);
+        });
+
+        return;
+    }
+
+    // Interleave heights across rows as upon initialization.
+    size_t entry = 0;
+    std::vector<hash_heights> shares(rows.size());
+    hashes.visit([&](const hash_digest& hash, size_t height)
+    {
+        shares[entry++ % shares.size()].insert(hash, height);
+    });
+
+    for (size_t row = 0; row < rows.size(); ++row)
+        rows[row]->insert(shares[row]);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Stall methods.
+//-----------------------------------------------------------------------------
+
+// A row that has received nothing within its rate-derived timeout holds up the
+// commit height, so its lowest block is also requested from a fast row.
+size_t reservations::rescue()
+{
+    typedef std::pair<size_t, reservation::ptr> stall;
+    std::vector<stall> stalls;
+    reservation::list fastest;
+
+#if defined(BITPRIM_DB_NEW)
+    size_t rescued = unblock() ? 1 : 0;
+#else
+    size_t rescued = 0;
+#endif
+
+    const auto lower = [](const stall& left, const stall& right)
+    {
+        return left.first < right.first;
+    };
+
+    const auto faster = [](reservation::ptr left, reservation::ptr right)
+    {
+        return left->rate().total() > right->rate().total();
+    };
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // A live row cannot stop while this lock is held (see reassign), so a
+    // hash inserted to a thief is requested or returned by its retirement.
+    for (const auto row: table_)
+    {
+        size_t height;
+        bool requested;
+        hash_digest hash;
+
+        if (row->stalled() && row->front(hash, height, requested) &&
+            requested)
+            stalls.emplace_back(height, row);
+
+        if (!row->idle() && !row->retired() && !row->empty())
+            fastest.push_back(row);
+    }
+
+    if (stalls.empty() || fastest.empty())
+        return rescued;
+
+    std::sort(stalls.begin(), stalls.end(), lower);
+    std::sort(fastest.begin(), fastest.end(), faster);
+
+    auto thief = fastest.begin();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock duplicates_lock(duplicates_mutex_);
+
+    // Assign the lowest stalls to the fastest rows, one block per row.
+    for (const auto& candidate: stalls)
+    {
+        size_t height;
+        bool requested;
+        hash_digest hash;
+        const auto holder = candidate.second;
+
+        if (thief == fastest.end())
+            break;
+
+        if (*thief == holder && ++thief == fastest.end())
+            break;
+
+        // The front may have arrived since the table was read.
+        if (!holder->front(hash, height, requested) || !requested ||
+            duplicates_.count(height) != 0)
+            continue;
+
+        duplicates_[height] = { holder, *thief, hash, false };
+        (*thief)->insert(std::move(hash), height);
+        ++rescued;
+
+        LOG_DEBUG(LOG_NODE)
+            << "Stalled block #" << height << " of slot (" << holder->slot()
+            << ") also requested from slot (" << (*thief)->slot() << ").";
+
+        ++thief;
+    }
+
+    return rescued;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The copy returned by a retired row is dropped with its entry, as the other
+// row holds the height, so it is not reassigned back to that row. An entry
+// with both copies in flight is resolved by the first arrival.
+void reservations::forget(reservation::ptr row, hash_heights& returned)
+{
+    size_t height;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(duplicates_mutex_);
+
+    for (auto it = duplicates_.begin(); it != duplicates_.end();)
+    {
+        const auto& entry = it->second;
+
+        if ((entry.holder == row || entry.thief == row) &&
+            returned.erase(entry.hash, height))
+            it = duplicates_.erase(it);
+        else
+            ++it;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A removed row holds no copy, so its entries would only block a rescue.
+void reservations::forget(reservation::ptr row)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(duplicates_mutex_);
+
+    for (auto it = duplicates_.begin(); it != duplicates_.end();)
+    {
+        const auto& entry = it->second;
+
+        if (entry.holder == row || entry.thief == row)
+            it = duplicates_.erase(it);
+        else
+            ++it;
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+#if defined(BITPRIM_DB_NEW)
+// Once saturated only the next commit height may be requested. Rows populate
+// only once empty, and rows holding unrequested heights above the ceiling do
+// not empty, so a next height left in the hash list is moved to a live row.
+bool reservations::unblock()
+{
+    hash_digest hash;
+    const auto height = buffer_.next();
+
+    if (!buffer_.saturated())
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // A live row cannot stop while this lock is held (see reassign).
+    const auto rows = find_live();
+
+    if (rows.empty() || !hashes_.take(hash, height))
+        return false;
+
+    const auto faster = [](reservation::ptr left, reservation::ptr right)
+    {
+        return left->rate().total() < right->rate().total();
+    };
+
+    const auto row = *std::max_element(rows.begin(), rows.end(), faster);
+    row->insert(std::move(hash), height);
+
+    LOG_DEBUG(LOG_NODE)
+        << "Saturated at block #" << height << ", reserved to slot ("
+        << row->slot() << ").";
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+#endif // BITPRIM_DB_NEW
+
+// The first arrival discards the other request. If the other has also been
+// received concurrently, its later resolution is rejected as a duplicate.
+bool reservations::resolve(reservation::ptr row, const hash_digest& hash,
+    size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(duplicates_mutex_);
+
+    const auto it = duplicates_.find(height);
+
+    if (it == duplicates_.end())
+        return true;
+
+    if (it->second.received)
+    {
+        duplicates_.erase(it);
+        return false;
+    }
+
+    const auto& entry = it->second;
+    const auto other = row == entry.holder ? entry.thief : entry.holder;
+
+    if (other->discard(hash))
+        duplicates_.erase(it);
+    else
+        it->second.received = true;
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
 }
 
 // Hash methods.
@@ -171,26 +768,23 @@ void reservations::initialize(size_t connections)
 
     table_.reserve(rows);
 
-    // Allocate up to 50k headers per row.
-    const auto max_allocation = rows * max_request();
-    const auto allocation = std::min(blocks, max_allocation);
+    for (; next_slot_ < rows; ++next_slot_)
+        table_.push_back(std::make_shared<reservation>(*this, next_slot_,
+            timeout_, window_));
 
-    for (size_t row = 0; row < rows; ++row)
-        table_.push_back(std::make_shared<reservation>(*this, row, timeout_));
-
-    size_t height;
-    hash_digest hash;
-
-    // The (allocation / rows) * rows cannot exceed allocation.
+    // Allocate up to the byte budget and up to 50k headers per row.
     // The remainder is retained by the hash list for later reservation.
-    for (size_t base = 0; base < (allocation / rows); ++base)
+    checkpoint::list entries;
+    const auto allocation = hashes_.dequeue(entries, rows * max_request(),
+        rows * reservation_bytes, profile_);
+
+    // Interleave heights across rows so that all rows start at the bottom.
+    // Neighboring heights are of similar size, so rows get similar bytes.
+    for (size_t entry = 0; entry < entries.size(); ++entry)
     {
-        for (size_t row = 0; row < rows; ++row)
-        {
-            DEBUG_ONLY(const auto result =) hashes_.dequeue(hash, height);
-            BITCOIN_ASSERT_MSG(result, "The checklist is empty.");
-            table_[row]->insert(std::move(hash), height);
-        }
+        auto& check = entries[entry];
+        table_[entry % rows]->insert(hash_digest(check.hash()),
+            check.height());
     }
 
     LOG_DEBUG(LOG_NODE)
@@ -230,37 +824,70 @@ reservation::ptr reservations::find_maximal()
     if (table_.empty())
         return nullptr;
 
-    // The maximal row is that with the most block hashes reserved.
+    // The maximal row is that with the most block hashes not yet requested.
     const auto comparer = [](reservation::ptr left, reservation::ptr right)
     {
-        return left->size() < right->size();
+        return left->unrequested() < right->unrequested();
     };
 
     return *std::max_element(table_.begin(), table_.end(), comparer);
 }
 
+reservation::list reservations::find_live() const
+{
+    reservation::list rows;
+
+    for (const auto row: table_)
+        if (!row->retired() && !row->empty())
+            rows.push_back(row);
+
+    return rows;
+}
+
+reservation::ptr reservations::find_slowest()
+{
+    reservation::ptr slowest;
+    auto minimum = 0.0;
+
+    for (const auto row: table_)
+    {
+        if (row->idle() || row->retired() || row->empty())
+            continue;
+
+        const auto rate = row->rate().normal();
+
+        if (!slowest || rate < minimum)
+        {
+            slowest = row;
+            minimum = rate;
+        }
+    }
+
+    return slowest;
+}
+
 // Return false if minimal is empty.
 bool reservations::reserve(reservation::ptr minimal)
 {
     if (!minimal->empty())
         return true;
 
-    const auto allocation = std::min(hashes_.size(), max_request());
+    // Small early blocks are allocated in greater number than large ones.
+    checkpoint::list entries;
+    hashes_.dequeue(entries, max_request(), reservation_bytes, profile_);
 
-    size_t height;
-    hash_digest hash;
-
-    for (size_t block = 0; block < allocation; ++block)
-    {
-        DEBUG_ONLY(const auto result =) hashes_.dequeue(hash, height);
-        BITCOIN_ASSERT_MSG(result, "The checklist is empty.");
-        minimal->insert(std::move(hash), height);
-    }
+    for (const auto& check: entries)
+        minimal->insert(hash_digest(check.hash()), check.height());
 
     // This may become empty between insert and this test, which is okay.
     return !minimal->empty();
 }
 
+const size_profile& reservations::profile() const
+{
+    return profile_;
+}
+
 // Exposed for test to be able to control the request size.
 size_t reservations::max_request() const
 {
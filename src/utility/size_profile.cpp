@@ -0,0 +1,226 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/size_profile.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+// A retarget period, short enough to follow the growth of block sizes.
+const size_t size_profile::interval = 2016;
+
+// The profile file identifier and format version.
+static constexpr uint32_t profile_magic = 0x7a73686e;
+static constexpr uint32_t profile_version = 1;
+
+typedef struct
+{
+    size_t height;
+    uint64_t bytes;
+} size_point;
+
+// Approximate mean mainnet block sizes, interpolated linearly between points.
+// Heights above the last point are estimated at the last size.
+static const size_point profile[]
+{
+    { 0, 250 },
+    { 70000, 500 },
+    { 100000, 5000 },
+    { 150000, 25000 },
+    { 200000, 100000 },
+    { 250000, 150000 },
+    { 300000, 350000 },
+    { 350000, 600000 },
+    { 400000, 900000 },
+    { 450000, 1000000 }
+};
+
+static constexpr size_t points = sizeof(profile) / sizeof(profile[0]);
+
+// Without a profile of the network, hashes are allocated by count alone, as
+// the budget is not reached by a full request of blocks of this size.
+static constexpr uint64_t flat_size = 250;
+
+size_profile::size_profile()
+  : mainnet_(true)
+{
+}
+
+size_profile::size_profile(const boost::filesystem::path& file, bool mainnet)
+  : file_(file), mainnet_(mainnet)
+{
+}
+
+bool size_profile::load()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    learned_.clear();
+
+    bc::ifstream file(file_.string(), std::ios::in | std::ios::binary);
+
+    if (file.fail())
+        return false;
+
+    istream_reader source(file);
+
+    if (source.read_4_bytes_little_endian() != profile_magic ||
+        source.read_4_bytes_little_endian() != profile_version)
+        return false;
+
+    const auto count = source.read_8_bytes_little_endian();
+
+    if (!source)
+        return false;
+
+    // A truncated file is discarded rather than trusted in part.
+    std::vector<summary> learned;
+
+    for (uint64_t bucket = 0; bucket < count && source; ++bucket)
+    {
+        const auto bytes = source.read_8_bytes_little_endian();
+        const auto blocks = source.read_4_bytes_little_endian();
+        learned.push_back({ bytes, blocks });
+    }
+
+    if (!source)
+        return false;
+
+    learned_.swap(learned);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The file is replaced by rename, so a failed write leaves the prior file.
+// Nothing is learned before a load, so an empty profile is not written.
+bool size_profile::save() const
+{
+    if (file_.empty())
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+    const auto learned = learned_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (learned.empty())
+        return true;
+
+    auto temporary = file_;
+    temporary += ".tmp";
+
+    {
+        bc::ofstream file(temporary.string(),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (file.fail())
+            return false;
+
+        ostream_writer sink(file);
+        sink.write_4_bytes_little_endian(profile_magic);
+        sink.write_4_bytes_little_endian(profile_version);
+        sink.write_8_bytes_little_endian(learned.size());
+
+        for (const auto& value: learned)
+        {
+            sink.write_8_bytes_little_endian(value.bytes);
+            sink.write_4_bytes_little_endian(value.blocks);
+        }
+
+        file.flush();
+
+        if (!sink || file.fail())
+            return false;
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(temporary, file_, ec);
+    return !ec;
+}
+
+uint64_t size_profile::shipped(size_t height)
+{
+    for (size_t index = 1; index < points; ++index)
+    {
+        const auto& upper = profile[index];
+
+        if (height >= upper.height)
+            continue;
+
+        const auto& lower = profile[index - 1];
+        const auto offset = height - lower.height;
+        const auto span = upper.height - lower.height;
+
+        // Sizes increase between points, so the difference is positive.
+        return lower.bytes + (upper.bytes - lower.bytes) * offset / span;
+    }
+
+    return profile[points - 1].bytes;
+}
+
+uint64_t size_profile::estimate(size_t height) const
+{
+    const auto bucket = height / interval;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    if (bucket < learned_.size() && learned_[bucket].blocks != 0)
+    {
+        const auto& value = learned_[bucket];
+        const auto mean = value.bytes / value.blocks;
+        mutex_.unlock_shared();
+        //---------------------------------------------------------------------
+        return mean;
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return mainnet_ ? shipped(height) : flat_size;
+}
+
+void size_profile::record(size_t height, size_t bytes)
+{
+    const auto bucket = height / interval;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (bucket >= learned_.size())
+        learned_.resize(bucket + 1, { 0, 0 });
+
+    auto& value = learned_[bucket];
+    value.bytes += bytes;
+    ++value.blocks;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
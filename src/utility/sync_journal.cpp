@@ -0,0 +1,399 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/sync_journal.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/height_bitmap.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::blockchain;
+using namespace bc::config;
+
+// The journal file identifier and format version.
+static constexpr uint32_t journal_magic = 0x6a736e62;
+static constexpr uint32_t journal_version = 1;
+
+// The journal log file identifier, of the same format version.
+static constexpr uint32_t log_magic = 0x6a736e6c;
+
+sync_journal::sync_journal(const boost::filesystem::path& file,
+    const checkpoint& last, const height_bitmap& populated)
+  : file_(file),
+    log_(file.string() + ".log"),
+    last_(last),
+    populated_(populated),
+    captured_(false),
+    written_(false),
+    logged_(0)
+{
+}
+
+bool sync_journal::captured() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return captured_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The journal is ignored if written against other checkpoints, since the
+// hashes were verified against them.
+bool sync_journal::load(check_list& hashes, fast_chain& chain)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    entries_.clear();
+    captured_ = false;
+    written_ = false;
+    logged_ = 0;
+
+    bc::ifstream file(file_.string(), std::ios::in | std::ios::binary);
+
+    if (file.fail())
+        return false;
+
+    istream_reader source(file);
+
+    if (source.read_4_bytes_little_endian() != journal_magic ||
+        source.read_4_bytes_little_endian() != journal_version)
+        return false;
+
+    const auto last_height = source.read_8_bytes_little_endian();
+    const auto last_hash = source.read_hash();
+
+    if (!source || last_height != last_.height() || last_hash != last_.hash())
+        return false;
+
+    const auto count = source.read_8_bytes_little_endian();
+
+    // Guard against a corrupt count.
+    if (!source || count > last_.height() + 1u)
+        return false;
+
+    entries_.reserve(count);
+
+    for (uint64_t entry = 0; entry < count && source; ++entry)
+    {
+        const auto height = source.read_8_bytes_little_endian();
+        entries_.emplace_back(source.read_hash(), height);
+    }
+
+    if (!source)
+    {
+        entries_.clear();
+        return false;
+    }
+
+    // The file and log match the entries unless some have since been stored.
+    heights stored;
+    written_ = replay();
+    prune(chain, stored);
+    written_ &= stored.empty();
+
+    if (entries_.empty())
+        return false;
+
+    check_list::heights heights;
+    heights.reserve(entries_.size());
+
+    for (const auto& entry: entries_)
+        heights.push_back(entry.height());
+
+    hashes.reserve(heights);
+
+    // Unknown headers remain null and are obtained by header sync.
+    for (const auto& entry: entries_)
+        if (entry.hash() != null_hash)
+            hashes.enqueue(hash_digest(entry.hash()), entry.height());
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void sync_journal::capture(const check_list& hashes)
+{
+    checkpoint::list entries;
+    hashes.snapshot(entries);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    entries_.swap(entries);
+    captured_ = true;
+    written_ = false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Entries are pruned under the mutex and written under the file mutex only,
+// so that captures are not held for the file write. Logging the stored
+// heights avoids rewriting a large journal on each save, and the log is
+// bounded by rewriting the entries once it outgrows them.
+bool sync_journal::save(fast_chain& chain, bool compact)
+{
+    heights stored;
+    checkpoint::list entries;
+    auto rewrite = false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section (file)
+    unique_lock file_lock(file_mutex_);
+
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        unique_lock lock(mutex_);
+
+        prune(chain, stored);
+        const auto logged = logged_ + stored.size();
+
+        // The file is current if no entry was captured or stored since.
+        rewrite = !written_ || (compact && logged != 0) ||
+            logged > entries_.size();
+
+        if (!rewrite && stored.empty())
+            return true;
+
+        if (rewrite)
+        {
+            entries = entries_;
+            written_ = true;
+            logged_ = 0;
+        }
+        else
+        {
+            logged_ = logged;
+        }
+        ///////////////////////////////////////////////////////////////////////
+    }
+
+    if (rewrite ? write(entries) : append(stored))
+        return true;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // A failed write or append is retried by rewriting on the next save.
+    written_ = false;
+    return false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool sync_journal::clear()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section (file)
+    unique_lock file_lock(file_mutex_);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    entries_.clear();
+    captured_ = false;
+    written_ = true;
+    logged_ = 0;
+
+    boost::system::error_code file_ec;
+    boost::system::error_code log_ec;
+    boost::filesystem::remove(file_, file_ec);
+    boost::filesystem::remove(log_, log_ec);
+    return !file_ec && !log_ec;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+//-----------------------------------------------------------------------------
+
+// A block is only requested once its header hash is known, so entries without
+// a hash are never stored.
+void sync_journal::prune(fast_chain& chain, heights& out_stored)
+{
+#if defined(BITPRIM_DB_NEW)
+    // Sequential stores are filled to their top.
+    size_t top;
+    if (!chain.get_last_height(top))
+        return;
+
+    const auto stored = [top](const checkpoint& entry)
+    {
+        return entry.height() <= top;
+    };
+#elif defined(BITPRIM_DB_LEGACY)
+    // The bitmap is set as each block is stored, avoiding a store query per
+    // entry on every save. Without it the store is queried.
+    const auto indexed = populated_.valid();
+
+    const auto stored = [&](const checkpoint& entry)
+    {
+        return entry.hash() != null_hash && (indexed ?
+            populated_.contains(entry.height()) :
+            chain.get_block_exists(entry.hash()));
+    };
+#else
+#error You must define BITPRIM_DB_LEGACY or BITPRIM_DB_NEW
+#endif
+
+    const auto end = std::stable_partition(entries_.begin(), entries_.end(),
+        [&](const checkpoint& entry) { return !stored(entry); });
+
+    for (auto entry = end; entry != entries_.end(); ++entry)
+        out_stored.push_back(entry->height());
+
+    entries_.erase(end, entries_.end());
+}
+
+// The log is only valid for the file it follows, since it is removed when the
+// file is rewritten. A partially appended height is ignored.
+bool sync_journal::replay()
+{
+    bc::ifstream file(log_.string(), std::ios::in | std::ios::binary);
+
+    // There is no log if nothing was stored since the file was written.
+    if (file.fail())
+        return true;
+
+    istream_reader source(file);
+
+    if (source.read_4_bytes_little_endian() != log_magic ||
+        source.read_4_bytes_little_endian() != journal_version || !source)
+        return false;
+
+    heights logged;
+
+    while (true)
+    {
+        const auto height = source.read_8_bytes_little_endian();
+
+        if (!source)
+            break;
+
+        logged.push_back(height);
+    }
+
+    std::sort(logged.begin(), logged.end());
+
+    const auto end = std::remove_if(entries_.begin(), entries_.end(),
+        [&](const checkpoint& entry)
+        {
+            return std::binary_search(logged.begin(), logged.end(),
+                entry.height());
+        });
+
+    entries_.erase(end, entries_.end());
+    logged_ = logged.size();
+    return true;
+}
+
+// The file is replaced by rename, so a failed write leaves the prior journal.
+bool sync_journal::write(const checkpoint::list& entries) const
+{
+    boost::system::error_code ec;
+
+    if (entries.empty())
+    {
+        boost::system::error_code log_ec;
+        boost::filesystem::remove(file_, ec);
+        boost::filesystem::remove(log_, log_ec);
+        return !ec && !log_ec;
+    }
+
+    auto temporary = file_;
+    temporary += ".tmp";
+
+    {
+        bc::ofstream file(temporary.string(),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (file.fail())
+            return false;
+
+        ostream_writer sink(file);
+        sink.write_4_bytes_little_endian(journal_magic);
+        sink.write_4_bytes_little_endian(journal_version);
+        sink.write_8_bytes_little_endian(last_.height());
+        sink.write_hash(last_.hash());
+        sink.write_8_bytes_little_endian(entries.size());
+
+        for (const auto& entry: entries)
+        {
+            sink.write_8_bytes_little_endian(entry.height());
+            sink.write_hash(entry.hash());
+        }
+
+        file.flush();
+
+        if (!sink || file.fail())
+            return false;
+    }
+
+    boost::filesystem::rename(temporary, file_, ec);
+
+    if (ec)
+        return false;
+
+    // The log heights are all stored, so a log left by a failure is harmless.
+    boost::filesystem::remove(log_, ec);
+    return !ec;
+}
+
+// The log is created with its header, and a failed append is retried by
+// rewriting the file, which removes the log.
+bool sync_journal::append(const heights& stored) const
+{
+    boost::system::error_code ec;
+    const auto exists = boost::filesystem::exists(log_, ec) &&
+        boost::filesystem::file_size(log_, ec) != 0 && !ec;
+
+    bc::ofstream file(log_.string(),
+        std::ios::out | std::ios::binary | std::ios::app);
+
+    if (file.fail())
+        return false;
+
+    ostream_writer sink(file);
+
+    if (!exists)
+    {
+        sink.write_4_bytes_little_endian(log_magic);
+        sink.write_4_bytes_little_endian(journal_version);
+    }
+
+    for (const auto height: stored)
+        sink.write_8_bytes_little_endian(height);
+
+    file.flush();
+    return sink && !file.fail();
+}
+
+} // namespace node
+} // namespace libbitcoin
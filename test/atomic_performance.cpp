@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(atomic_performance_tests)
+
+BOOST_AUTO_TEST_CASE(atomic_performance__load__initial__expected)
+{
+    const atomic_performance instance({ true, 1, 2, 3 });
+    const auto value = instance.load();
+    BOOST_REQUIRE(value.idle);
+    BOOST_REQUIRE(instance.idle());
+    BOOST_REQUIRE_EQUAL(value.events, 1u);
+    BOOST_REQUIRE_EQUAL(value.database, 2u);
+    BOOST_REQUIRE_EQUAL(value.window, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(atomic_performance__store__value__loaded)
+{
+    atomic_performance instance({ true, 0, 0, 0 });
+    instance.store({ false, 42, 24, 84 });
+    const auto value = instance.load();
+    BOOST_REQUIRE(!value.idle);
+    BOOST_REQUIRE(!instance.idle());
+    BOOST_REQUIRE_EQUAL(value.events, 42u);
+    BOOST_REQUIRE_EQUAL(value.database, 24u);
+    BOOST_REQUIRE_EQUAL(value.window, 84u);
+}
+
+BOOST_AUTO_TEST_CASE(atomic_performance__load__concurrent_store__consistent)
+{
+    static const size_t stores = 100000;
+    atomic_performance instance({ false, 0, 0, 0 });
+    std::atomic<bool> done(false);
+    std::atomic<size_t> torn(0);
+
+    // Each stored record has equal fields, so a torn read is detectable.
+    std::thread reader([&]()
+    {
+        while (!done)
+        {
+            const auto value = instance.load();
+
+            if (value.events != value.database ||
+                value.database != value.window)
+                ++torn;
+        }
+    });
+
+    for (size_t value = 1; value <= stores; ++value)
+        instance.store({ false, value, value, value });
+
+    done = true;
+    reader.join();
+    BOOST_REQUIRE_EQUAL(torn.load(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.load().events, stores);
+}
+
+// benchmark
+//-----------------------------------------------------------------------------
+
+// The prior reservation rate cell, for comparison.
+class locked_performance
+{
+public:
+    locked_performance(const performance& value)
+      : value_(value)
+    {
+    }
+
+    performance load() const
+    {
+        shared_lock lock(mutex_);
+        return value_;
+    }
+
+    void store(const performance& value)
+    {
+        unique_lock lock(mutex_);
+        value_ = value;
+    }
+
+private:
+    performance value_;
+    mutable upgrade_mutex mutex_;
+};
+
+// Each slot thread publishes its own rate and reads every other slot rate,
+// as each block import and expiry test does. Returns reads per second.
+template <typename Cell>
+static double reads_per_second(size_t slots, size_t rounds)
+{
+    std::vector<std::unique_ptr<Cell>> cells;
+
+    for (size_t slot = 0; slot < slots; ++slot)
+        cells.emplace_back(new Cell({ false, 0, 0, 0 }));
+
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> checksum(0);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t slot = 0; slot < slots; ++slot)
+    {
+        threads.emplace_back([&cells, &checksum, slot, slots, rounds]()
+        {
+            uint64_t sum = 0;
+
+            for (size_t round = 0; round < rounds; ++round)
+            {
+                cells[slot]->store({ false, round, round, round });
+
+                for (size_t other = 0; other < slots; ++other)
+                    sum += cells[other]->load().events;
+            }
+
+            checksum += sum;
+        });
+    }
+
+    for (auto& thread: threads)
+        thread.join();
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double> elapsed(end - start);
+    BOOST_REQUIRE_GT(checksum.load(), 0u);
+    return (slots * slots * rounds) / elapsed.count();
+}
+
+BOOST_AUTO_TEST_CASE(atomic_performance__benchmark__many_slots__versus_locked)
+{
+    static const size_t slots = 32;
+    static const size_t rounds = 2000;
+    const auto locked = reads_per_second<locked_performance>(slots, rounds);
+    const auto atomic = reads_per_second<atomic_performance>(slots, rounds);
+
+    BOOST_TEST_MESSAGE("locked: " << locked << " reads/s, atomic: " << atomic
+        << " reads/s (" << atomic / locked << "x)");
+    BOOST_REQUIRE_GT(atomic, 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(block_requests_tests)
+
+static const auto timeout = std::chrono::seconds(10);
+static const auto start = block_requests::clock::now();
+static const auto later = start + std::chrono::seconds(11);
+
+static hash_digest hash_of(uint8_t value)
+{
+    hash_digest hash = null_hash;
+    hash.front() = value;
+    return hash;
+}
+
+static const auto hash1 = hash_of(1);
+static const auto hash2 = hash_of(2);
+static const auto hash3 = hash_of(3);
+
+BOOST_AUTO_TEST_CASE(block_requests__construct__default__empty)
+{
+    const block_requests instance(2, timeout);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.count(1), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__claim__above_limit__limited)
+{
+    block_requests instance(2, timeout);
+    hash_list out;
+    instance.claim(1, { hash1, hash2, hash3 }, out, start);
+    BOOST_REQUIRE((out == hash_list{ hash1, hash2 }));
+    BOOST_REQUIRE_EQUAL(instance.count(1), 2u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__claim__held_by_other__unclaimed)
+{
+    block_requests instance(2, timeout);
+    hash_list out;
+    instance.claim(1, { hash1 }, out, start);
+    out.clear();
+    instance.claim(2, { hash1, hash2 }, out, start);
+    BOOST_REQUIRE((out == hash_list{ hash2 }));
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__claim__held_by_self__claimed)
+{
+    block_requests instance(1, timeout);
+    hash_list out;
+    instance.claim(1, { hash1 }, out, start);
+    instance.claim(1, { hash1 }, out, start);
+    BOOST_REQUIRE((out == hash_list{ hash1, hash1 }));
+    BOOST_REQUIRE_EQUAL(instance.count(1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__reclaim__timed_out__reassigned)
+{
+    block_requests instance(2, timeout);
+    hash_list out;
+    instance.claim(1, { hash1 }, out, start);
+    instance.claim(2, { hash1 }, out, start);
+
+    out.clear();
+    instance.reclaim(2, out, start);
+    BOOST_REQUIRE(out.empty());
+
+    instance.reclaim(2, out, later);
+    BOOST_REQUIRE((out == hash_list{ hash1 }));
+    BOOST_REQUIRE_EQUAL(instance.count(1), 0u);
+    BOOST_REQUIRE_EQUAL(instance.count(2), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__reclaim__released__announcement_order)
+{
+    block_requests instance(2, timeout);
+    hash_list out;
+    instance.claim(1, { hash1, hash2, hash3 }, out, start);
+    instance.claim(2, { hash1, hash2 }, out, start);
+    instance.release(1);
+
+    out.clear();
+    instance.reclaim(2, out, start);
+    BOOST_REQUIRE((out == hash_list{ hash1, hash2 }));
+
+    // The third hash was announced only by the released peer.
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__complete__other_peer__false_removed)
+{
+    block_requests instance(2, timeout);
+    hash_list out;
+    instance.claim(1, { hash1 }, out, start);
+    instance.claim(2, { hash1 }, out, start);
+    BOOST_REQUIRE(!instance.complete(2, hash1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.count(1), 0u);
+    BOOST_REQUIRE(!instance.complete(1, hash1));
+}
+
+BOOST_AUTO_TEST_CASE(block_requests__complete__holder__true)
+{
+    block_requests instance(2, timeout);
+    hash_list out;
+    instance.claim(1, { hash1 }, out, start);
+    BOOST_REQUIRE(instance.complete(1, hash1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,12 +20,154 @@
 #include <bitcoin/node.hpp>
 
 using namespace bc;
+using namespace bc::config;
+using namespace bc::node;
 
 BOOST_AUTO_TEST_SUITE(check_list_tests)
 
-BOOST_AUTO_TEST_CASE(todo)
+static hash_digest hash_of(size_t height)
 {
-    BOOST_REQUIRE(true);
+    return bitcoin_hash(to_chunk(to_little_endian(height)));
+}
+
+BOOST_AUTO_TEST_CASE(check_list__construct__default__empty)
+{
+    const check_list instance;
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__reserve__gaps__reserved_count)
+{
+    check_list instance;
+    instance.reserve({ 5, 7, 8, 12 });
+    BOOST_REQUIRE_EQUAL(instance.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__enqueue__unreserved__ignored)
+{
+    check_list instance;
+    instance.reserve({ 5, 7 });
+    instance.enqueue(hash_of(6), 6);
+    instance.enqueue(hash_of(9), 9);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(instance.dequeue(hash, height));
+    BOOST_REQUIRE_EQUAL(height, 5u);
+    BOOST_REQUIRE(hash == null_hash);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__dequeue__reserved__increasing_heights)
+{
+    check_list instance;
+    instance.reserve({ 12, 5, 8, 7 });
+
+    for (const auto height: { 5u, 7u, 8u, 12u })
+        instance.enqueue(hash_of(height), height);
+
+    hash_digest hash;
+    size_t height;
+
+    for (const auto expected: { 5u, 7u, 8u, 12u })
+    {
+        BOOST_REQUIRE(instance.dequeue(hash, height));
+        BOOST_REQUIRE_EQUAL(height, expected);
+        BOOST_REQUIRE(hash == hash_of(expected));
+    }
+
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE(!instance.dequeue(hash, height));
+}
+
+BOOST_AUTO_TEST_CASE(check_list__dequeue__batch__bounded_by_count)
+{
+    check_list instance;
+    instance.reserve({ 1, 2, 4, 5, 6 });
+
+    checkpoint::list entries;
+    BOOST_REQUIRE_EQUAL(instance.dequeue(entries, 3), 3u);
+    BOOST_REQUIRE_EQUAL(entries.size(), 3u);
+    BOOST_REQUIRE_EQUAL(entries[2].height(), 4u);
+
+    BOOST_REQUIRE_EQUAL(instance.dequeue(entries, 10), 2u);
+    BOOST_REQUIRE_EQUAL(entries.size(), 5u);
+    BOOST_REQUIRE_EQUAL(entries.back().height(), 6u);
+    BOOST_REQUIRE(instance.empty());
+}
+
+BOOST_AUTO_TEST_CASE(check_list__dequeue__budget__bounded_by_bytes)
+{
+    check_list instance;
+    instance.reserve({ 1, 2, 3, 4, 5 });
+
+    // Each early block is estimated at the first shipped size.
+    size_profile profile;
+    const auto size = profile.estimate(1);
+
+    checkpoint::list entries;
+    BOOST_REQUIRE_EQUAL(instance.dequeue(entries, 10, 2 * size, profile), 2u);
+    BOOST_REQUIRE_EQUAL(entries.back().height(), 2u);
+
+    // A learned size above the budget still yields one entry.
+    profile.record(3, 4 * size);
+    BOOST_REQUIRE_EQUAL(instance.dequeue(entries, 10, size, profile), 1u);
+    BOOST_REQUIRE_EQUAL(entries.back().height(), 3u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__restore__dequeued__dequeued_first)
+{
+    check_list instance;
+    instance.reserve({ 1, 2, 3 });
+    instance.enqueue(hash_of(1), 1);
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(instance.dequeue(hash, height));
+    BOOST_REQUIRE(instance.dequeue(hash, height));
+    instance.restore(hash_of(1), 1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+
+    BOOST_REQUIRE(instance.dequeue(hash, height));
+    BOOST_REQUIRE_EQUAL(height, 1u);
+    BOOST_REQUIRE(hash == hash_of(1));
+}
+
+BOOST_AUTO_TEST_CASE(check_list__snapshot__partially_dequeued__remaining_entries)
+{
+    check_list instance;
+    instance.reserve({ 1, 2, 4 });
+    instance.enqueue(hash_of(4), 4);
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(instance.dequeue(hash, height));
+
+    checkpoint::list entries;
+    instance.snapshot(entries);
+    BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+    BOOST_REQUIRE_EQUAL(entries[0].height(), 2u);
+    BOOST_REQUIRE(entries[0].hash() == null_hash);
+    BOOST_REQUIRE_EQUAL(entries[1].height(), 4u);
+    BOOST_REQUIRE(entries[1].hash() == hash_of(4));
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__missing__known_and_unknown__lowest_unknown)
+{
+    check_list instance;
+    instance.reserve({ 1, 2, 3 });
+    instance.enqueue(hash_of(1), 1);
+    instance.enqueue(hash_of(3), 3);
+
+    size_t height;
+    BOOST_REQUIRE(instance.missing(height));
+    BOOST_REQUIRE_EQUAL(height, 2u);
+
+    instance.enqueue(hash_of(2), 2);
+    BOOST_REQUIRE(!instance.missing(height));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(hash_batch_tests)
+
+static const std::vector<hash_batch::kernel> kernels
+{
+    hash_batch::kernel::scalar,
+    hash_batch::kernel::avx2,
+    hash_batch::kernel::shani
+};
+
+static data_chunk pattern(size_t size, size_t seed)
+{
+    data_chunk data(size);
+
+    for (size_t index = 0; index < size; ++index)
+        data[index] = static_cast<uint8_t>(index * 31 + seed * 7);
+
+    return data;
+}
+
+static hash_digest reference_root(hash_list hashes)
+{
+    if (hashes.empty())
+        return null_hash;
+
+    while (hashes.size() > 1)
+    {
+        if (hashes.size() % 2 != 0)
+            hashes.push_back(hashes.back());
+
+        hash_list level;
+
+        for (size_t index = 0; index < hashes.size(); index += 2)
+            level.push_back(bitcoin_hash(build_chunk(
+            {
+                hashes[index], hashes[index + 1]
+            })));
+
+        hashes = level;
+    }
+
+    return hashes.front();
+}
+
+// construct
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(hash_batch__construct__default__fastest)
+{
+    const hash_batch instance;
+    BOOST_REQUIRE(instance.engine() == hash_batch::fastest());
+    BOOST_REQUIRE(hash_batch::supported(instance.engine()));
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__construct__kernel__supported_or_scalar)
+{
+    for (const auto kernel: kernels)
+    {
+        const hash_batch instance(kernel);
+        const auto expected = hash_batch::supported(kernel) ? kernel :
+            hash_batch::kernel::scalar;
+        BOOST_REQUIRE(instance.engine() == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__supported__scalar__true)
+{
+    BOOST_REQUIRE(hash_batch::supported(hash_batch::kernel::scalar));
+}
+
+// hash
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(hash_batch__hash__genesis_header__expected)
+{
+    const auto genesis = block::genesis_mainnet().header();
+    const header::list headers{ genesis };
+
+    for (const auto kernel: kernels)
+    {
+        const auto hashes = hash_batch(kernel).hash(headers);
+        BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+        BOOST_REQUIRE(hashes.front() == genesis.hash());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__hash__empty__unchanged)
+{
+    for (const auto kernel: kernels)
+    {
+        const auto hashes = hash_batch(kernel).hash(header::list{});
+        BOOST_REQUIRE(hashes.empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__hash__varied_sizes__bitcoin_hash)
+{
+    // Sizes span the one and two block padding boundaries (55/56 and 119/120)
+    // and the count is not a multiple of the vector lane count.
+    static const size_t count = 203;
+    std::vector<data_chunk> messages;
+    std::vector<const uint8_t*> pointers;
+    std::vector<size_t> sizes;
+
+    for (size_t index = 0; index < count; ++index)
+        messages.push_back(pattern(index, index));
+
+    for (const auto& message: messages)
+    {
+        pointers.push_back(message.data());
+        sizes.push_back(message.size());
+    }
+
+    for (const auto kernel: kernels)
+    {
+        hash_list hashes(count);
+        hash_batch(kernel).hash(hashes.data(), pointers.data(), sizes.data(),
+            count);
+
+        for (size_t index = 0; index < count; ++index)
+            BOOST_REQUIRE(hashes[index] == bitcoin_hash(messages[index]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__hash__contiguous_headers__bitcoin_hash)
+{
+    static const size_t size = 80;
+    static const size_t count = 19;
+    const auto data = pattern(size * count, 42);
+
+    for (const auto kernel: kernels)
+    {
+        hash_list hashes(count);
+        hash_batch(kernel).hash(hashes.data(), data.data(), size, count);
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            const auto begin = data.begin() + index * size;
+            const data_chunk message(begin, begin + size);
+            BOOST_REQUIRE(hashes[index] == bitcoin_hash(message));
+        }
+    }
+}
+
+// merkle_root
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(hash_batch__merkle_root__empty__null_hash)
+{
+    BOOST_REQUIRE(hash_batch().merkle_root({}) == null_hash);
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__merkle_root__single__unchanged)
+{
+    const auto hash = bitcoin_hash(pattern(10, 1));
+    BOOST_REQUIRE(hash_batch().merkle_root({ hash }) == hash);
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__merkle_root__odd_levels__expected)
+{
+    hash_list hashes;
+
+    for (size_t index = 0; index < 37; ++index)
+        hashes.push_back(bitcoin_hash(pattern(index, index)));
+
+    const auto expected = reference_root(hashes);
+
+    for (const auto kernel: kernels)
+        BOOST_REQUIRE(hash_batch(kernel).merkle_root(hashes) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__merkle_root__genesis__expected)
+{
+    const auto genesis = block::genesis_mainnet();
+    const hash_batch instance;
+    const auto root = instance.merkle_root(
+        instance.hash(genesis.transactions()));
+    BOOST_REQUIRE(root == genesis.header().merkle());
+}
+
+// benchmark
+//-----------------------------------------------------------------------------
+
+static double headers_per_second(const hash_batch& instance,
+    const data_chunk& data, size_t count, size_t rounds)
+{
+    hash_list hashes(count);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t round = 0; round < rounds; ++round)
+        instance.hash(hashes.data(), data.data(), 80, count);
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double> elapsed(end - start);
+    return (count * rounds) / elapsed.count();
+}
+
+BOOST_AUTO_TEST_CASE(hash_batch__benchmark__headers_message__versus_scalar)
+{
+    static const size_t count = max_get_headers;
+    static const size_t rounds = 50;
+    const auto data = pattern(80 * count, 7);
+    const auto scalar = headers_per_second(
+        hash_batch(hash_batch::kernel::scalar), data, count, rounds);
+
+    for (const auto kernel: kernels)
+    {
+        if (!hash_batch::supported(kernel))
+            continue;
+
+        const auto rate = headers_per_second(hash_batch(kernel), data, count,
+            rounds);
+
+        BOOST_TEST_MESSAGE("kernel " << static_cast<int>(kernel) << ": "
+            << rate << " headers/s (" << rate / scalar << "x scalar)");
+        BOOST_REQUIRE_GT(rate, 0.0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
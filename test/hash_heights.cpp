@@ -0,0 +1,326 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <vector>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(hash_heights_tests)
+
+static hash_digest hash_of(size_t height)
+{
+    return bitcoin_hash(to_chunk(to_little_endian(height)));
+}
+
+static std::vector<size_t> heights_of(const hash_heights& instance)
+{
+    std::vector<size_t> heights;
+    instance.visit([&heights](const hash_digest& hash, size_t height)
+    {
+        BOOST_REQUIRE(hash == hash_of(height));
+        heights.push_back(height);
+    });
+
+    return heights;
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__construct__default__empty)
+{
+    const hash_heights instance;
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__insert__ordered__visited_in_order)
+{
+    hash_heights instance;
+
+    for (size_t height = 1; height <= 100; ++height)
+        instance.insert(hash_of(height), height);
+
+    const auto heights = heights_of(instance);
+    BOOST_REQUIRE_EQUAL(instance.size(), 100u);
+    BOOST_REQUIRE_EQUAL(heights.size(), 100u);
+    BOOST_REQUIRE_EQUAL(heights.front(), 1u);
+    BOOST_REQUIRE_EQUAL(heights.back(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__insert__unordered__visited_in_order)
+{
+    hash_heights instance;
+    instance.insert(hash_of(10), 10);
+    instance.insert(hash_of(30), 30);
+    instance.insert(hash_of(20), 20);
+
+    const std::vector<size_t> expected{ 10, 20, 30 };
+    const auto heights = heights_of(instance);
+    BOOST_REQUIRE(heights == expected);
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(20), height));
+    BOOST_REQUIRE_EQUAL(height, 20u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__insert__below_erased_front__lowest_first)
+{
+    hash_heights instance;
+
+    for (size_t height = 10; height <= 20; ++height)
+        instance.insert(hash_of(height), height);
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(10), height));
+    BOOST_REQUIRE(instance.erase(hash_of(11), height));
+    BOOST_REQUIRE(instance.erase(hash_of(15), height));
+
+    // Rescued and rejected hashes return below the front.
+    instance.insert(hash_of(5), 5);
+    instance.insert(hash_of(4), 4);
+    instance.insert(hash_of(3), 3);
+
+    // An interior height is placed in order.
+    instance.insert(hash_of(15), 15);
+
+    const std::vector<size_t> expected
+    {
+        3, 4, 5, 12, 13, 14, 15, 16, 17, 18, 19, 20
+    };
+
+    BOOST_REQUIRE(heights_of(instance) == expected);
+    BOOST_REQUIRE(instance.erase(hash_of(4), height));
+    BOOST_REQUIRE_EQUAL(height, 4u);
+    BOOST_REQUIRE(instance.erase(hash_of(15), height));
+    BOOST_REQUIRE_EQUAL(height, 15u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__merge__interleaved__height_order)
+{
+    hash_heights instance;
+    hash_heights other;
+
+    for (size_t height = 0; height < 1000; height += 2)
+    {
+        instance.insert(hash_of(height), height);
+        other.insert(hash_of(height + 1), height + 1);
+    }
+
+    hash_list hashes;
+    instance.request(10, hashes);
+    instance.merge(other);
+
+    const auto heights = heights_of(instance);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1000u);
+    BOOST_REQUIRE_EQUAL(instance.requested(), 10u);
+    BOOST_REQUIRE_EQUAL(other.size(), 500u);
+
+    for (size_t height = 0; height < heights.size(); ++height)
+        BOOST_REQUIRE_EQUAL(heights[height], height);
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(999), height));
+    BOOST_REQUIRE_EQUAL(height, 999u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__erase__missing__false)
+{
+    hash_heights instance;
+    size_t height;
+    BOOST_REQUIRE(!instance.erase(hash_of(1), height));
+
+    instance.insert(hash_of(1), 1);
+    BOOST_REQUIRE(!instance.erase(hash_of(2), height));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__erase__present__height_and_removed)
+{
+    hash_heights instance;
+
+    for (size_t height = 1; height <= 1000; ++height)
+        instance.insert(hash_of(height), height);
+
+    size_t height;
+
+    for (size_t expected = 2; expected <= 1000; expected += 2)
+    {
+        BOOST_REQUIRE(instance.erase(hash_of(expected), height));
+        BOOST_REQUIRE_EQUAL(height, expected);
+    }
+
+    BOOST_REQUIRE_EQUAL(instance.size(), 500u);
+    BOOST_REQUIRE(!instance.erase(hash_of(2), height));
+    BOOST_REQUIRE(instance.erase(hash_of(999), height));
+    BOOST_REQUIRE_EQUAL(height, 999u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__erase__reinserted__found)
+{
+    hash_heights instance;
+    instance.insert(hash_of(1), 1);
+    instance.insert(hash_of(2), 2);
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(2), height));
+    instance.insert(hash_of(2), 2);
+    BOOST_REQUIRE(instance.erase(hash_of(2), height));
+    BOOST_REQUIRE_EQUAL(height, 2u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__move_front__half__lowest_moved)
+{
+    hash_heights instance;
+    hash_heights other;
+
+    for (size_t height = 1; height <= 9; ++height)
+        instance.insert(hash_of(height), height);
+
+    instance.move_front(other, 5);
+
+    const std::vector<size_t> moved{ 1, 2, 3, 4, 5 };
+    const std::vector<size_t> kept{ 6, 7, 8, 9 };
+    BOOST_REQUIRE(heights_of(other) == moved);
+    BOOST_REQUIRE(heights_of(instance) == kept);
+
+    size_t height;
+    BOOST_REQUIRE(other.erase(hash_of(3), height));
+    BOOST_REQUIRE(!instance.erase(hash_of(3), height));
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__request__window__lowest_unrequested)
+{
+    hash_heights instance;
+
+    for (size_t height = 1; height <= 10; ++height)
+        instance.insert(hash_of(height), height);
+
+    hash_list hashes;
+    instance.request(3, hashes);
+    BOOST_REQUIRE_EQUAL(instance.requested(), 3u);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 3u);
+    BOOST_REQUIRE(hashes.front() == hash_of(1));
+    BOOST_REQUIRE(hashes.back() == hash_of(3));
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(2), height));
+    BOOST_REQUIRE_EQUAL(instance.requested(), 2u);
+
+    hashes.clear();
+    instance.request(2, hashes);
+    BOOST_REQUIRE_EQUAL(instance.requested(), 4u);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
+    BOOST_REQUIRE(hashes.front() == hash_of(4));
+    BOOST_REQUIRE(hashes.back() == hash_of(5));
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__reset_requests__requested__all_requestable)
+{
+    hash_heights instance;
+
+    for (size_t height = 1; height <= 4; ++height)
+        instance.insert(hash_of(height), height);
+
+    hash_list hashes;
+    instance.request(4, hashes);
+    instance.reset_requests();
+    BOOST_REQUIRE_EQUAL(instance.requested(), 0u);
+
+    hashes.clear();
+    instance.request(10, hashes);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 4u);
+    BOOST_REQUIRE_EQUAL(instance.requested(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__move_back__requested__only_unrequested_moved)
+{
+    hash_heights instance;
+    hash_heights other;
+
+    for (size_t height = 1; height <= 9; ++height)
+        instance.insert(hash_of(height), height);
+
+    hash_list hashes;
+    instance.request(3, hashes);
+    instance.move_back(other, 4);
+
+    const std::vector<size_t> moved{ 6, 7, 8, 9 };
+    const std::vector<size_t> kept{ 1, 2, 3, 4, 5 };
+    BOOST_REQUIRE(heights_of(other) == moved);
+    BOOST_REQUIRE(heights_of(instance) == kept);
+    BOOST_REQUIRE_EQUAL(instance.requested(), 3u);
+    BOOST_REQUIRE_EQUAL(other.requested(), 0u);
+
+    // Requested entries are never moved.
+    instance.move_back(other, 10);
+    const std::vector<size_t> remaining{ 1, 2, 3 };
+    BOOST_REQUIRE(heights_of(instance) == remaining);
+    BOOST_REQUIRE_EQUAL(other.size(), 6u);
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(3), height));
+    BOOST_REQUIRE(other.erase(hash_of(4), height));
+    BOOST_REQUIRE_EQUAL(height, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__front__empty__false)
+{
+    const hash_heights instance;
+    hash_digest hash;
+    size_t height;
+    bool requested;
+    BOOST_REQUIRE(!instance.front(hash, height, requested));
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__front__erased_and_moved__lowest_live)
+{
+    hash_heights instance;
+    hash_heights other;
+
+    for (size_t height = 1; height <= 6; ++height)
+        instance.insert(hash_of(height), height);
+
+    size_t height;
+    BOOST_REQUIRE(instance.erase(hash_of(3), height));
+    instance.move_front(other, 2);
+
+    hash_list hashes;
+    instance.request(1, hashes);
+
+    hash_digest hash;
+    bool requested;
+    BOOST_REQUIRE(instance.front(hash, height, requested));
+    BOOST_REQUIRE_EQUAL(height, 4u);
+    BOOST_REQUIRE(hash == hash_of(4));
+    BOOST_REQUIRE(requested);
+}
+
+BOOST_AUTO_TEST_CASE(hash_heights__clear__populated__empty)
+{
+    hash_heights instance;
+    instance.insert(hash_of(1), 1);
+    instance.clear();
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE(heights_of(instance).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(header_tree_tests)
+
+// The genesis headers are valid competing children of the null hash.
+static const auto mainnet = block::genesis_mainnet().header();
+static const auto testnet = block::genesis_testnet().header();
+
+// The mainnet block at height 1, the only child of the mainnet genesis.
+static const header mainnet1(1, mainnet.hash(),
+    hash_literal("0e3e2357e806b6cdb1f70b54c3a3a17b6714ee1f0e68bebb44a74b1efd512098"),
+    1231469665, 0x1d00ffff, 2573394689);
+
+BOOST_AUTO_TEST_CASE(header_tree__construct__default__empty)
+{
+    const header_tree instance(10, 10, 10, true);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__empty__accepted_unchanged)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    BOOST_REQUIRE(instance.add(1, {}, fetch) == header_tree::status::accepted);
+    BOOST_REQUIRE(fetch.empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__unlinked__orphan)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(mainnet.hash(), 0);
+    hash_list fetch;
+    BOOST_REQUIRE(instance.add(1, { testnet }, fetch) ==
+        header_tree::status::orphan);
+    BOOST_REQUIRE(fetch.empty());
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__target_above_limit__invalid)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    const auto regtest = block::genesis_regtest().header();
+    BOOST_REQUIRE(instance.add(1, { regtest }, fetch) ==
+        header_tree::status::invalid);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__more_work__fetch_and_tip)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    BOOST_REQUIRE(instance.add(1, { mainnet }, fetch) ==
+        header_tree::status::accepted);
+    BOOST_REQUIRE_EQUAL(fetch.size(), 1u);
+    BOOST_REQUIRE(fetch.front() == mainnet.hash());
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(instance.tip(1, hash, height));
+    BOOST_REQUIRE(hash == mainnet.hash());
+    BOOST_REQUIRE_EQUAL(height, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__equal_work_branch__no_fetch)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(null_hash, 0);
+    instance.connect(mainnet, 1);
+    hash_list fetch;
+    BOOST_REQUIRE(instance.add(2, { testnet }, fetch) ==
+        header_tree::status::accepted);
+    BOOST_REQUIRE(fetch.empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__connect__unlinked__anchored)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(mainnet.hash(), 5);
+    instance.connect(testnet, 1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__connect__below_depth__pruned)
+{
+    header_tree instance(0, 10, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    instance.add(1, { mainnet }, fetch);
+    instance.connect(mainnet, 1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(instance.tip(1, hash, height));
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__peer_maximum__saturated)
+{
+    header_tree instance(10, 10, 1, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    BOOST_REQUIRE(instance.add(1, { mainnet }, fetch) ==
+        header_tree::status::accepted);
+    BOOST_REQUIRE(instance.add(1, { testnet }, fetch) ==
+        header_tree::status::saturated);
+    BOOST_REQUIRE(instance.add(2, { testnet }, fetch) ==
+        header_tree::status::accepted);
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__maximum__weak_branch_evicted)
+{
+    header_tree instance(10, 3, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    instance.add(1, { testnet }, fetch);
+    instance.connect(mainnet, 1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+
+    // The testnet branch has no more work than the chain, so it is dropped.
+    fetch.clear();
+    BOOST_REQUIRE(instance.add(2, { mainnet1 }, fetch) ==
+        header_tree::status::accepted);
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+    BOOST_REQUIRE_EQUAL(fetch.size(), 1u);
+    BOOST_REQUIRE(fetch.front() == mainnet1.hash());
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(!instance.tip(1, hash, height));
+    BOOST_REQUIRE(instance.tip(2, hash, height));
+    BOOST_REQUIRE_EQUAL(height, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__add__maximum_of_stronger_branches__saturated)
+{
+    header_tree instance(10, 2, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    BOOST_REQUIRE(instance.add(1, { mainnet }, fetch) ==
+        header_tree::status::accepted);
+    BOOST_REQUIRE(instance.add(2, { testnet }, fetch) ==
+        header_tree::status::saturated);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(header_tree__remove__tip__forgotten)
+{
+    header_tree instance(10, 10, 10, true);
+    instance.anchor(null_hash, 0);
+    hash_list fetch;
+    instance.add(1, { mainnet }, fetch);
+    instance.remove(1);
+
+    hash_digest hash;
+    size_t height;
+    BOOST_REQUIRE(!instance.tip(1, hash, height));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
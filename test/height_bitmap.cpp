@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(height_bitmap_tests)
+
+static const auto bitmap_file = "height_bitmap_test";
+
+BOOST_AUTO_TEST_CASE(height_bitmap__construct__default__invalid_empty)
+{
+    const height_bitmap instance(bitmap_file);
+    BOOST_REQUIRE(!instance.valid());
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+    BOOST_REQUIRE(!instance.contains(0));
+}
+
+BOOST_AUTO_TEST_CASE(height_bitmap__save__invalid__false)
+{
+    height_bitmap instance(bitmap_file);
+    instance.set(0);
+    BOOST_REQUIRE(!instance.save(0));
+}
+
+BOOST_AUTO_TEST_CASE(height_bitmap__gaps__assigned_across_words__gaps)
+{
+    height_bitmap instance(bitmap_file);
+    instance.assign({ 0, 63, 64, 130 }, 200);
+    BOOST_REQUIRE(instance.valid());
+    BOOST_REQUIRE_EQUAL(instance.count(), 197u);
+
+    height_bitmap::heights gaps;
+    instance.gaps(gaps, 200);
+    BOOST_REQUIRE((gaps == height_bitmap::heights{ 0, 63, 64, 130 }));
+}
+
+BOOST_AUTO_TEST_CASE(height_bitmap__gaps__set_and_reset__updated)
+{
+    height_bitmap instance(bitmap_file);
+    instance.assign({ 5, 6 }, 10);
+    instance.set(5);
+    instance.reset(9);
+    BOOST_REQUIRE(instance.contains(5));
+    BOOST_REQUIRE(!instance.contains(9));
+
+    height_bitmap::heights gaps;
+    instance.gaps(gaps, 12);
+    BOOST_REQUIRE((gaps == height_bitmap::heights{ 6, 9, 11, 12 }));
+}
+
+BOOST_AUTO_TEST_CASE(height_bitmap__load__saved__restored)
+{
+    height_bitmap writer(bitmap_file);
+    writer.assign({ 3, 100 }, 150);
+    BOOST_REQUIRE(writer.save(150));
+
+    height_bitmap reader(bitmap_file);
+    BOOST_REQUIRE(!reader.load(151));
+    BOOST_REQUIRE(reader.load(150));
+    BOOST_REQUIRE_EQUAL(reader.count(), 149u);
+
+    height_bitmap::heights gaps;
+    reader.gaps(gaps, 150);
+    BOOST_REQUIRE((gaps == height_bitmap::heights{ 3, 100 }));
+}
+
+BOOST_AUTO_TEST_CASE(height_bitmap__set__after_load__file_removed)
+{
+    height_bitmap writer(bitmap_file);
+    writer.assign({ 3 }, 10);
+    BOOST_REQUIRE(writer.save(10));
+
+    height_bitmap reader(bitmap_file);
+    BOOST_REQUIRE(reader.load(10));
+    reader.set(2);
+    BOOST_REQUIRE(boost::filesystem::exists(bitmap_file));
+
+    reader.set(3);
+    BOOST_REQUIRE(!boost::filesystem::exists(bitmap_file));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
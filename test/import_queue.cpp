@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(import_queue_tests)
+
+BOOST_AUTO_TEST_CASE(import_queue__push__not_started__run_inline)
+{
+    import_queue instance(2);
+    auto run = false;
+    instance.push([&run]() { run = true; });
+    BOOST_REQUIRE(run);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__try_push__not_started__dropped)
+{
+    import_queue instance(2);
+    auto run = false;
+    BOOST_REQUIRE(!instance.try_push([&run]() { run = true; }));
+    BOOST_REQUIRE(!run);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__try_push__started__run)
+{
+    import_queue instance(2);
+    auto run = false;
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.try_push([&run]() { run = true; }));
+    instance.stop();
+    BOOST_REQUIRE(run);
+    BOOST_REQUIRE(!instance.try_push([]() {}));
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__start__twice__false)
+{
+    import_queue instance(2);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(!instance.start());
+    instance.stop();
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__stop__queued__all_run_in_order)
+{
+    static const size_t count = 1000;
+    import_queue instance(10);
+    std::vector<size_t> order;
+    BOOST_REQUIRE(instance.start());
+
+    for (size_t job = 0; job < count; ++job)
+        instance.push([&order, job]() { order.push_back(job); });
+
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(order.size(), count);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+
+    for (size_t job = 0; job < count; ++job)
+        BOOST_REQUIRE_EQUAL(order[job], job);
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__full__blocked_job__true)
+{
+    import_queue instance(2);
+    std::atomic<bool> release(false);
+    BOOST_REQUIRE(instance.start());
+
+    // The running job counts toward capacity until it completes.
+    instance.push([&release]() { while (!release) std::this_thread::yield(); });
+    BOOST_REQUIRE(!instance.full());
+    instance.push([]() {});
+    BOOST_REQUIRE(instance.full());
+
+    release = true;
+    instance.stop();
+    BOOST_REQUIRE(!instance.full());
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__push__many_producers__all_run)
+{
+    static const size_t producers = 4;
+    static const size_t jobs = 500;
+    import_queue instance(16);
+    std::atomic<size_t> run(0);
+    std::vector<std::thread> threads;
+    BOOST_REQUIRE(instance.start());
+
+    for (size_t producer = 0; producer < producers; ++producer)
+        threads.emplace_back([&instance, &run]()
+        {
+            for (size_t job = 0; job < jobs; ++job)
+                instance.push([&run]() { ++run; });
+        });
+
+    for (auto& thread: threads)
+        thread.join();
+
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(run.load(), producers * jobs);
+}
+
+BOOST_AUTO_TEST_CASE(import_queue__push__many_threads__all_run)
+{
+    static const size_t jobs = 1000;
+    import_queue instance(16, 4);
+    std::atomic<size_t> run(0);
+    BOOST_REQUIRE(instance.start());
+
+    for (size_t job = 0; job < jobs; ++job)
+        instance.push([&run]() { ++run; });
+
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(run.load(), jobs);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
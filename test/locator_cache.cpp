@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <bitcoin/node.hpp>
+#include "utility.hpp"
+
+using namespace bc;
+using namespace bc::node;
+using namespace bc::node::test;
+
+BOOST_AUTO_TEST_SUITE(locator_cache_tests)
+
+// The test hash of a height encodes the height.
+static hash_digest hash_of(size_t height)
+{
+    hash_digest hash = null_hash;
+    std::memcpy(hash.data(), &height, sizeof(height));
+    return hash;
+}
+
+static size_t height_of(const hash_digest& hash)
+{
+    size_t height;
+    std::memcpy(&height, hash.data(), sizeof(height));
+    return height;
+}
+
+// A chain of the specified top, optionally missing the hash of a height.
+class chain_fixture
+  : public blockchain_fixture
+{
+public:
+    chain_fixture(size_t top, size_t missing=max_size_t)
+      : top_(top), missing_(missing)
+    {
+    }
+
+    bool get_last_height(size_t& out_height) const override
+    {
+        out_height = top_;
+        return true;
+    }
+
+    bool get_block_hash(hash_digest& out_hash, size_t height) const override
+    {
+        if (height > top_ || height == missing_)
+            return false;
+
+        out_hash = hash_of(height);
+        return true;
+    }
+
+private:
+    const size_t top_;
+    const size_t missing_;
+};
+
+static std::vector<size_t> heights_of(const hash_list& hashes)
+{
+    std::vector<size_t> heights;
+
+    for (const auto& hash: hashes)
+        heights.push_back(height_of(hash));
+
+    return heights;
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__construct__default__empty)
+{
+    const locator_cache instance;
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE(instance.hashes().empty());
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__rebuild__no_top__false_empty)
+{
+    locator_cache instance;
+    const blockchain_fixture chain;
+    BOOST_REQUIRE(!instance.rebuild(chain));
+    BOOST_REQUIRE(instance.empty());
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__rebuild__missing_hash__false_empty)
+{
+    locator_cache instance;
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(100)));
+    BOOST_REQUIRE(!instance.rebuild(chain_fixture(100, 95)));
+    BOOST_REQUIRE(instance.empty());
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__hashes__below_ten__all_heights)
+{
+    locator_cache instance;
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(4)));
+    const auto hashes = instance.hashes();
+    BOOST_REQUIRE_EQUAL(hashes.size(), 5u);
+
+    for (size_t index = 0; index < hashes.size(); ++index)
+        BOOST_REQUIRE_EQUAL(height_of(hashes[index]), 4u - index);
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__hashes__power_of_two_top__doubling_distances)
+{
+    locator_cache instance;
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(1024)));
+    const std::vector<size_t> expected
+    {
+        1024, 1023, 1022, 1021, 1020, 1019, 1018, 1017, 1016, 1015,
+        1014, 1012, 1008, 1000, 984, 952, 888, 760, 504, 0
+    };
+
+    const auto heights = heights_of(instance.hashes());
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(heights.begin(), heights.end(),
+        expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__hashes__next_top__all_heights_moved)
+{
+    locator_cache instance;
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(1024)));
+    const auto prior = heights_of(instance.hashes());
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(1025)));
+    const auto heights = heights_of(instance.hashes());
+    BOOST_REQUIRE_EQUAL(heights.size(), prior.size());
+
+    // Each height but genesis is the same distance below the new top.
+    for (size_t index = 0; index + 1 < heights.size(); ++index)
+        BOOST_REQUIRE_EQUAL(heights[index], prior[index] + 1u);
+
+    BOOST_REQUIRE_EQUAL(heights.back(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__hashes__high_top__recent_then_sparse)
+{
+    static const size_t top = 5000;
+    locator_cache instance;
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(top)));
+    const auto hashes = instance.hashes();
+
+    // Ten consecutive heights, then growing steps to genesis.
+    BOOST_REQUIRE_LT(hashes.size(), 30u);
+    BOOST_REQUIRE_EQUAL(height_of(hashes.back()), 0u);
+
+    for (size_t index = 0; index < 10; ++index)
+        BOOST_REQUIRE_EQUAL(height_of(hashes[index]), top - index);
+
+    for (size_t index = 1; index < hashes.size(); ++index)
+        BOOST_REQUIRE_LT(height_of(hashes[index]), height_of(hashes[index - 1]));
+}
+
+BOOST_AUTO_TEST_CASE(locator_cache__clear__built__empty)
+{
+    locator_cache instance;
+    BOOST_REQUIRE(instance.rebuild(chain_fixture(3)));
+    instance.clear();
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE(instance.hashes().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
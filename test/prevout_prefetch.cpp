@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(prevout_prefetch_tests)
+
+// A transaction spending count outputs of the previous hash.
+static transaction spend(const hash_digest& previous, uint32_t count)
+{
+    input::list inputs;
+
+    for (uint32_t index = 0; index < count; ++index)
+        inputs.push_back({ { previous, index }, {}, max_input_sequence });
+
+    return { 1, 0, inputs, {} };
+}
+
+static const transaction coinbase
+{
+    1, 0, { { output_point{ null_hash, point::null_index }, {}, 0 } }, {}
+};
+
+BOOST_AUTO_TEST_CASE(prevout_prefetch__prefetch__stopped__none)
+{
+    std::atomic<size_t> lookups(0);
+    prevout_prefetch instance([&lookups](const output_point&) { ++lookups; },
+        10, 2);
+    BOOST_REQUIRE_EQUAL(instance.prefetch({ spend(null_hash, 3) }), 0u);
+    BOOST_REQUIRE_EQUAL(lookups, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(prevout_prefetch__start__twice__false)
+{
+    prevout_prefetch instance([](const output_point&) {}, 10, 2);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(!instance.start());
+    instance.stop();
+}
+
+BOOST_AUTO_TEST_CASE(prevout_prefetch__prefetch__mixed__valid_spends_only)
+{
+    std::atomic<size_t> lookups(0);
+    prevout_prefetch instance([&lookups](const output_point&) { ++lookups; },
+        10, 2);
+    BOOST_REQUIRE(instance.start());
+
+    // Missing transactions of a compact block are default constructed.
+    const transaction::list transactions
+    {
+        coinbase, spend(null_hash, 100), transaction{}, spend(null_hash, 3)
+    };
+
+    BOOST_REQUIRE_EQUAL(instance.prefetch(transactions), 103u);
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(lookups, 103u);
+}
+
+BOOST_AUTO_TEST_CASE(prevout_prefetch__prefetch__full__dropped)
+{
+    // Slow lookups keep the first batch running while the rest are pushed.
+    std::atomic<size_t> lookups(0);
+    const auto slow = [&lookups](const output_point&)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++lookups;
+    };
+
+    prevout_prefetch instance(slow, 1, 1);
+    BOOST_REQUIRE(instance.start());
+
+    const auto queued = instance.prefetch({ spend(null_hash, 1000) });
+    instance.stop();
+    BOOST_REQUIRE_LT(queued, 1000u);
+    BOOST_REQUIRE_EQUAL(lookups, queued);
+}
+
+BOOST_AUTO_TEST_CASE(prevout_prefetch__prefetch__concurrent_stop__never_inline)
+{
+    std::atomic<bool> inline_lookup(false);
+    std::atomic<bool> stopped(false);
+    std::thread::id caller;
+
+    prevout_prefetch instance([&](const output_point&)
+    {
+        if (std::this_thread::get_id() == caller)
+            inline_lookup = true;
+    }, 10, 2);
+
+    BOOST_REQUIRE(instance.start());
+
+    std::thread producer([&]()
+    {
+        caller = std::this_thread::get_id();
+
+        while (!stopped)
+            instance.prefetch({ spend(null_hash, 3) });
+    });
+
+    // Lookups are dropped rather than run on the caller once stopping.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    instance.stop();
+    stopped = true;
+    producer.join();
+    BOOST_REQUIRE(!inline_lookup);
+    BOOST_REQUIRE_EQUAL(instance.prefetch({ spend(null_hash, 3) }), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
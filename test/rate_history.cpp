@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(rate_history_tests)
+
+typedef rate_history::time_point time_point;
+static const auto epoch = time_point{};
+
+static time_point at(size_t seconds)
+{
+    return epoch + std::chrono::seconds(seconds);
+}
+
+BOOST_AUTO_TEST_CASE(rate_history__construct__default__empty)
+{
+    const rate_history instance(4);
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.events(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.database(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(rate_history__push__three__summed)
+{
+    rate_history instance(4);
+    instance.push(1, 10, at(1));
+    instance.push(2, 20, at(2));
+    instance.push(3, 30, at(3));
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+    BOOST_REQUIRE_EQUAL(instance.events(), 6u);
+    BOOST_REQUIRE_EQUAL(instance.database(), 60u);
+    BOOST_REQUIRE(instance.front() == at(1));
+}
+
+BOOST_AUTO_TEST_CASE(rate_history__push__full__oldest_dropped)
+{
+    rate_history instance(2);
+    instance.push(1, 10, at(1));
+    instance.push(2, 20, at(2));
+    instance.push(3, 30, at(3));
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.events(), 5u);
+    BOOST_REQUIRE_EQUAL(instance.database(), 50u);
+    BOOST_REQUIRE(instance.front() == at(2));
+}
+
+BOOST_AUTO_TEST_CASE(rate_history__expire__older__removed_true)
+{
+    rate_history instance(4);
+    instance.push(1, 10, at(1));
+    instance.push(2, 20, at(2));
+    instance.push(3, 30, at(3));
+
+    BOOST_REQUIRE(!instance.expire(at(1)));
+    BOOST_REQUIRE(instance.expire(at(3)));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.events(), 3u);
+    BOOST_REQUIRE_EQUAL(instance.database(), 30u);
+    BOOST_REQUIRE(instance.front() == at(3));
+}
+
+BOOST_AUTO_TEST_CASE(rate_history__expire__wrapped__sums_consistent)
+{
+    rate_history instance(3);
+
+    for (size_t second = 1; second <= 10; ++second)
+    {
+        instance.push(second, second, at(second));
+        instance.expire(at(second - 1));
+    }
+
+    // Records 9 and 10 remain within the window.
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.events(), 19u);
+    BOOST_REQUIRE_EQUAL(instance.database(), 19u);
+    BOOST_REQUIRE(instance.expire(at(11)));
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE_EQUAL(instance.events(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(rate_history__clear__populated__empty)
+{
+    rate_history instance(2);
+    instance.push(1, 10, at(1));
+    instance.clear();
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE_EQUAL(instance.events(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.database(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
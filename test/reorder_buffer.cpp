@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(reorder_buffer_tests)
+
+static block_const_ptr make_block()
+{
+    return std::make_shared<const message::block>(
+        chain::block::genesis_mainnet());
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__construct__default__empty)
+{
+    const reorder_buffer instance(42, 1000);
+    BOOST_REQUIRE_EQUAL(instance.next(), 42u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 0u);
+    BOOST_REQUIRE(!instance.saturated());
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__pop__gap__null)
+{
+    reorder_buffer instance(10, 1000000);
+    BOOST_REQUIRE(instance.push(make_block(), 11));
+
+    size_t height;
+    BOOST_REQUIRE(!instance.pop(height));
+    BOOST_REQUIRE_EQUAL(instance.next(), 10u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__pop__out_of_order__height_order)
+{
+    reorder_buffer instance(10, 1000000);
+    BOOST_REQUIRE(instance.push(make_block(), 12));
+    BOOST_REQUIRE(instance.push(make_block(), 10));
+    BOOST_REQUIRE(instance.push(make_block(), 11));
+
+    size_t height;
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE_EQUAL(height, 10u);
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE_EQUAL(height, 11u);
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE_EQUAL(height, 12u);
+    BOOST_REQUIRE(!instance.pop(height));
+    BOOST_REQUIRE_EQUAL(instance.next(), 13u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__push__released_or_duplicate__false)
+{
+    reorder_buffer instance(10, 1000000);
+    BOOST_REQUIRE(!instance.push(make_block(), 9));
+    BOOST_REQUIRE(instance.push(make_block(), 10));
+    BOOST_REQUIRE(!instance.push(make_block(), 10));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    size_t height;
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE(!instance.push(make_block(), 10));
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__saturated__capacity_reached__true)
+{
+    const auto block = make_block();
+    const auto size = block->serialized_size();
+    reorder_buffer instance(0, 2 * size);
+
+    BOOST_REQUIRE(instance.push(block, 2));
+    BOOST_REQUIRE(!instance.saturated());
+    BOOST_REQUIRE(instance.push(block, 1));
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 2 * size);
+    BOOST_REQUIRE(instance.saturated());
+
+    BOOST_REQUIRE(instance.push(block, 0));
+
+    size_t height;
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE(instance.saturated());
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE(!instance.saturated());
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__restore__last_released__next_reset)
+{
+    reorder_buffer instance(10, 1000000);
+    BOOST_REQUIRE(instance.push(make_block(), 10));
+    BOOST_REQUIRE(instance.push(make_block(), 11));
+
+    size_t height;
+    const auto block = instance.pop(height);
+    BOOST_REQUIRE(block);
+    BOOST_REQUIRE(instance.restore(block, height));
+    BOOST_REQUIRE_EQUAL(instance.next(), 10u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE_EQUAL(height, 10u);
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer__restore__not_last_released__false)
+{
+    reorder_buffer instance(10, 1000000);
+    BOOST_REQUIRE(instance.push(make_block(), 10));
+    BOOST_REQUIRE(instance.push(make_block(), 11));
+
+    size_t height;
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE(instance.pop(height));
+    BOOST_REQUIRE(!instance.restore(make_block(), 10));
+    BOOST_REQUIRE_EQUAL(instance.next(), 12u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
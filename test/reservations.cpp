@@ -16,682 +16,570 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-////#include <algorithm>
-////#include <memory>
-////#include <boost/test/unit_test.hpp>
-////#include <bitcoin/node.hpp>
-////#include "utility.hpp"
-////
-////using namespace bc;
-////using namespace bc::config;
-////using namespace bc::message;
-////using namespace bc::node;
-////using namespace bc::node::test;
-////
-////BOOST_AUTO_TEST_SUITE(reservations_tests)
-////
-////// max_request
-//////-----------------------------------------------------------------------------
-////
-////BOOST_AUTO_TEST_CASE(reservations__max_request__default__50000)
-////{
-////    DECLARE_RESERVATIONS(reserves, true);
-////    BOOST_REQUIRE_EQUAL(reserves.max_request(), 50000u);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__set_max_request__42__42)
-////{
-////    DECLARE_RESERVATIONS(reserves, true);
-////    reserves.set_max_request(42);
-////    BOOST_REQUIRE_EQUAL(reserves.max_request(), 42u);
-////}
-////
-////// import
-//////-----------------------------------------------------------------------------
-////
-////BOOST_AUTO_TEST_CASE(reservations__import__true__true)
-////{
-////    const auto block_ptr = std::make_shared<const block>();
-////    DECLARE_RESERVATIONS(reserves, true);
-////    BOOST_REQUIRE(reserves.import(block_ptr, 42));
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__import__false__false)
-////{
-////    const auto block_ptr = std::make_shared<const block>();
-////    DECLARE_RESERVATIONS(reserves, false);
-////    BOOST_REQUIRE(!reserves.import(block_ptr, 42));
-////}
-////
-////// table
-//////-----------------------------------------------------------------------------
-////
-////BOOST_AUTO_TEST_CASE(reservations__table__default__empty)
-////{
-////    DECLARE_RESERVATIONS(reserves, true);
-////    BOOST_REQUIRE(reserves.table().empty());
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__table__hash_1__size_1_by_1_hashes_empty)
-////{
-////    node::settings settings;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    hashes.initialize(check42);
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[0]->slot(), 0u);
-////    BOOST_REQUIRE(hashes.empty());
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__table__hash_4__size_4_by_1_hashes_empty)
-////{
-////    node::settings settings;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(3, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 4u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[3]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[0]->slot(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[1]->slot(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->slot(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[3]->slot(), 3u);
-////    BOOST_REQUIRE(hashes.empty());
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__table__connections_5_hash_46__size_5_by_9_hashes_1)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 5;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(45, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 9u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 9u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 9u);
-////    BOOST_REQUIRE_EQUAL(table[3]->size(), 9u);
-////    BOOST_REQUIRE_EQUAL(table[4]->size(), 9u);
-////    BOOST_REQUIRE_EQUAL(table[0]->slot(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[1]->slot(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->slot(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[3]->slot(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[4]->slot(), 4u);
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__table__hash_42__size_8_by_5_hashes_2)
-////{
-////    node::settings settings;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(41, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 8u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[3]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[4]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[5]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[6]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[7]->size(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[0]->slot(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[1]->slot(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->slot(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[3]->slot(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[4]->slot(), 4u);
-////    BOOST_REQUIRE_EQUAL(table[5]->slot(), 5u);
-////    BOOST_REQUIRE_EQUAL(table[6]->slot(), 6u);
-////    BOOST_REQUIRE_EQUAL(table[7]->slot(), 7u);
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
-////}
-////
-////// remove
-//////-----------------------------------------------------------------------------
-////
-////BOOST_AUTO_TEST_CASE(reservations__remove__empty__does_not_throw)
-////{
-////    node::settings settings;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    hashes.initialize(check42);
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 1u);
-////
-////    const auto row = table[0];
-////    reserves.remove(row);
-////    BOOST_REQUIRE(reserves.table().empty());
-////    BOOST_REQUIRE_NO_THROW(reserves.remove(row));
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__remove__hash_4__size_3)
-////{
-////    node::settings settings;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(3, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table1 = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table1.size(), 4u);
-////    BOOST_REQUIRE(hashes.empty());
-////
-////    const auto row = table1[2];
-////    BOOST_REQUIRE_EQUAL(row->slot(), 2u);
-////
-////    reserves.remove(row);
-////    const auto table2 = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table2.size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table2[0]->slot(), 0u);
-////    BOOST_REQUIRE_EQUAL(table2[1]->slot(), 1u);
-////    BOOST_REQUIRE_EQUAL(table2[2]->slot(), 3u);
-////}
-////
-////// populate
-//////-----------------------------------------------------------------------------
-////
-////BOOST_AUTO_TEST_CASE(reservations__populate__hashes_not_empty_row_not_empty__no_population)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 3;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(9, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 3u);
-////
-////    // All rows have three hashes.
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u);
-////
-////    // The row is not empty so must not cause a reserve.
-////    // The row is not empty so must not cause a repartitioning.
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
-////    BOOST_REQUIRE(reserves.populate(table[1]));
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
-////
-////    // All rows still have three hashes.
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__populate__hashes_empty_row_not_empty__no_population)
-////{
-////    node::settings settings;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(3, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 4u);
-////
-////    // All rows have one hash.
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[3]->size(), 1u);
-////
-////    // There are no hashes in reserve.
-////    BOOST_REQUIRE(hashes.empty());
-////
-////    // The row is not empty so must not cause a repartitioning.
-////    BOOST_REQUIRE(reserves.populate(table[0]));
-////
-////    // Partitions remain unchanged.
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[3]->size(), 1u);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__populate__hashes_empty_table_empty__no_population)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 3;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////
-////    // Initialize with a known header so we can import its block later.
-////    const auto message = message_factory(3, null_hash);
-////    auto& elements = message->elements();
-////    const auto genesis_header = elements[0];
-////    hashes.initialize(genesis_header.hash(), 0);
-////    elements.erase(std::find(elements.begin(), elements.end(), elements[0]));
-////    BOOST_REQUIRE_EQUAL(elements.size(), 2u);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 3u);
-////
-////    // There are no hashes in reserve.
-////    BOOST_REQUIRE(hashes.empty());
-////
-////    // Declare blocks that hash to the allocated headers.
-////    // Blocks are evenly distrubuted (every third to each row).
-////    const auto block0 = std::make_shared<const block>(block{ genesis_header, {} });
-////    const auto block1 = std::make_shared<const block>(block{ elements[0], {} });
-////    const auto block2 = std::make_shared<const block>(block{ elements[1], {} });
-////
-////    // All rows have one hash.
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u); // 0
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u); // 1
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u); // 2
-////
-////    // Remove all rows from the member table.
-////    reserves.remove(table[0]);
-////    reserves.remove(table[1]);
-////    reserves.remove(table[2]);
-////    BOOST_REQUIRE(reserves.table().empty());
-////
-////    // Removing a block from the first row of the cached table must result in
-////    // one less hash in that row and no partitioning of other rows, since they
-////    // are no longer accessible from the member table.
-////    table[0]->import(block0);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 0u); //
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u); // 1
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u); // 2
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__populate__hashes_not_empty_row_emptied__uncapped_reserve)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 3;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(7, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 3u);
-////
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 2u);
-////
-////    const auto block1 = std::make_shared<block>(block{ message->elements()[0], {} });
-////    const auto block4 = std::make_shared<block>(block{ message->elements()[3], {} });
-////
-////    // The import of two blocks from same row will cause populate to invoke reservation.
-////    table[1]->import(block1);
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u);
-////
-////    // The reserve is reduced from 2 to 0 (unlimited by max_request default of 50000).
-////    table[1]->import(block4);
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 2u);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__populate__hashes_not_empty_row_emptied__capped_reserve)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 3;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(7, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 3u);
-////
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 2u);
-////
-////    // Cap reserve at 1 block.
-////    reserves.set_max_request(1);
-////
-////    const auto block1 = std::make_shared<const block>(block{ message->elements()[0], {} });
-////    const auto block4 = std::make_shared<const block>(block{ message->elements()[3], {} });
-////
-////    // The import of two blocks from same row will cause populate to invoke reservation.
-////    table[1]->import(block1);
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u);
-////
-////    // The reserve is reduced from 2 to 1 (limited by max_request of 1).
-////    table[1]->import(block4);
-////    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__populate__hashes_empty_rows_emptied__partition)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 3;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////
-////    // Initialize with a known header so we can import its block later.
-////    const auto message = message_factory(9, null_hash);
-////    auto& elements = message->elements();
-////    const auto genesis_header = elements[0];
-////    hashes.initialize(genesis_header.hash(), 0);
-////    elements.erase(std::find(elements.begin(), elements.end(), elements[0]));
-////    BOOST_REQUIRE_EQUAL(elements.size(), 8u);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 3u);
-////
-////    // There are no hashes in reserve.
-////    BOOST_REQUIRE(hashes.empty());
-////
-////    // Declare blocks that hash to the allocated headers.
-////    // Blocks are evenly distrubuted (every third to each row).
-////    const auto block0 = std::make_shared<const block>(block{ genesis_header, {} });
-////    const auto block1 = std::make_shared<const block>(block{ elements[0], {} });
-////    const auto block2 = std::make_shared<const block>(block{ elements[1], {} });
-////    const auto block3 = std::make_shared<const block>(block{ elements[2], {} });
-////    const auto block4 = std::make_shared<const block>(block{ elements[3], {} });
-////    const auto block5 = std::make_shared<const block>(block{ elements[4], {} });
-////    const auto block6 = std::make_shared<const block>(block{ elements[5], {} });
-////    const auto block7 = std::make_shared<const block>(block{ elements[6], {} });
-////    const auto block8 = std::make_shared<const block>(block{ elements[7], {} });
-////
-////    // This will reset pending on all rows.
-////    BOOST_REQUIRE_EQUAL(table[0]->request(false).inventories().size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[1]->request(false).inventories().size(), 3u);
-////    BOOST_REQUIRE_EQUAL(table[2]->request(false).inventories().size(), 3u);
-////
-////    // A row becomes stopped once empty.
-////    BOOST_REQUIRE(!table[0]->stopped());
-////    BOOST_REQUIRE(!table[1]->stopped());
-////    BOOST_REQUIRE(!table[2]->stopped());
-////
-////    // All rows have three hashes.
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 3u); // 0/3/6
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 3u); // 1/4/7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u); // 2/5/8
-////
-////    // Remove a block from the first row.
-////    table[0]->import(block0);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u); // 3/6
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 3u); // 1/4/7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u); // 2/5/8
-////
-////    // Remove another block from the first row.
-////    table[0]->import(block3);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u); // 6
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 3u); // 1/4/7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u); // 2/5/8
-////
-////    // Removing the last block from the first row results in partitioning of
-////    // of the highst row (row 1 winds the tie with row 2 due to ordering).
-////    // Half of the row 1 allocation is moved to row 0, rounded up to 2 hashes.
-////    table[0]->import(block6);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u); // 1/4
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u); // 7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u); // 2/5/8
-////    BOOST_REQUIRE(table[1]->toggle_partitioned());
-////    BOOST_REQUIRE(!table[1]->toggle_partitioned());
-////
-////    // The last row has not been modified.
-////    BOOST_REQUIRE_EQUAL(table[0]->request(false).inventories().size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->request(false).inventories().size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[2]->request(false).inventories().size(), 0u);
-////
-////    // The rows are no longer pending.
-////    BOOST_REQUIRE(table[0]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[1]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[2]->request(false).inventories().empty());
-////
-////    // Remove another block from the first row (originally from the second).
-////    table[0]->import(block1);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u); // 4
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u); // 7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 3u); // 2/5/8
-////
-////    // Remove another block from the first row (originally from the second).
-////    table[0]->import(block4);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 2u); // 2/5
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u); // 7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u); // 8
-////    BOOST_REQUIRE(table[2]->toggle_partitioned());
-////    BOOST_REQUIRE(!table[2]->toggle_partitioned());
-////
-////    // The second row has not been modified.
-////    BOOST_REQUIRE_EQUAL(table[0]->request(false).inventories().size(), 2u);
-////    BOOST_REQUIRE_EQUAL(table[1]->request(false).inventories().size(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[2]->request(false).inventories().size(), 1u);
-////
-////    // The rows are no longer pending.
-////    BOOST_REQUIRE(table[0]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[1]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[2]->request(false).inventories().empty());
-////
-////    // Remove another block from the first row (originally from the third).
-////    table[0]->import(block2);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u); // 5
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 1u); // 7
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u); // 8
-////
-////    // Remove another block from the first row (originally from the third).
-////    table[0]->import(block5);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u); // 7
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 0u); //
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 1u); // 8
-////    BOOST_REQUIRE(table[1]->stopped());
-////    BOOST_REQUIRE(!table[1]->toggle_partitioned());
-////
-////    // The third row has not been modified and the second row is empty.
-////    BOOST_REQUIRE_EQUAL(table[0]->request(false).inventories().size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[1]->request(false).inventories().size(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[2]->request(false).inventories().size(), 0u);
-////
-////    // The rows are no longer pending.
-////    BOOST_REQUIRE(table[0]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[1]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[2]->request(false).inventories().empty());
-////
-////    // Remove another block from the first row (originally from the second).
-////    table[0]->import(block7);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 1u); // 8
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 0u); //
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 0u); //
-////    BOOST_REQUIRE(table[2]->stopped());
-////    BOOST_REQUIRE(!table[2]->toggle_partitioned());
-////
-////    // The second row has not been modified and the third row is empty.
-////    BOOST_REQUIRE_EQUAL(table[0]->request(false).inventories().size(), 1u);
-////    BOOST_REQUIRE_EQUAL(table[1]->request(false).inventories().size(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[2]->request(false).inventories().size(), 0u);
-////
-////    // The rows are no longer pending.
-////    BOOST_REQUIRE(table[0]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[1]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[2]->request(false).inventories().empty());
-////
-////    // Remove another block from the first row (originally from the third).
-////    table[0]->import(block8);
-////    BOOST_REQUIRE_EQUAL(table[0]->size(), 0u); //
-////    BOOST_REQUIRE_EQUAL(table[1]->size(), 0u); //
-////    BOOST_REQUIRE_EQUAL(table[2]->size(), 0u); //
-////    BOOST_REQUIRE(table[0]->stopped());
-////
-////    // The second and third rows have not been modified and the first is empty.
-////    BOOST_REQUIRE_EQUAL(table[0]->request(false).inventories().size(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[1]->request(false).inventories().size(), 0u);
-////    BOOST_REQUIRE_EQUAL(table[2]->request(false).inventories().size(), 0u);
-////
-////    // The rows are no longer pending.
-////    BOOST_REQUIRE(table[0]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[1]->request(false).inventories().empty());
-////    BOOST_REQUIRE(table[2]->request(false).inventories().empty());
-////
-////    // We can't test the partition aspect of population directly
-////    // because there is no way to reduce the row count to empty.
-////    ////BOOST_REQUIRE(reserves.populate(table[0]));
-////}
-////
-////// rates
-//////-----------------------------------------------------------------------------
-////
-////BOOST_AUTO_TEST_CASE(reservations__rates__default__zeros)
-////{
-////    DECLARE_RESERVATIONS(reserves, true);
-////    const auto rates = reserves.rates();
-////    BOOST_REQUIRE_EQUAL(rates.active_count, 0u);
-////    BOOST_REQUIRE_EQUAL(rates.arithmentic_mean, 0.0);
-////    BOOST_REQUIRE_EQUAL(rates.standard_deviation, 0.0);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__rates__three_reservations_same_rates__no_deviation)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 3;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(2, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////    BOOST_REQUIRE_EQUAL(table.size(), 3u);
-////
-////    const auto rates1 = reserves.rates();
-////    BOOST_REQUIRE_EQUAL(rates1.active_count, 0u);
-////    BOOST_REQUIRE_EQUAL(rates1.arithmentic_mean, 0.0);
-////    BOOST_REQUIRE_EQUAL(rates1.standard_deviation, 0.0);
-////
-////    // normalized rates: 5 / (2 - 1) = 5
-////    performance rate0;
-////    rate0.idle = false;
-////    rate0.events = 5;
-////    rate0.database = 1;
-////    rate0.window = 2;
-////    performance rate1 = rate0;
-////    performance rate2 = rate0;
-////
-////    // Simulate the rate summary on each channel by setting it directly.
-////    table[0]->set_rate(std::move(rate0));
-////    table[1]->set_rate(std::move(rate1));
-////    table[2]->set_rate(std::move(rate2));
-////
-////    const auto rates2 = reserves.rates();
-////
-////    // There are three active (non-idle) rows.
-////    BOOST_REQUIRE_EQUAL(rates2.active_count, 3u);
-////
-////    // mean: (5 + 5 + 5) / 3 = 5
-////    BOOST_REQUIRE_EQUAL(rates2.arithmentic_mean, 5.0);
-////
-////    // deviations: { 5-5=0, 5-5=0, 5-5=0 }
-////    // variance: (0^2 + 0^2 + 0^2) / 3 = 0
-////    // standard deviation: sqrt(0)
-////    BOOST_REQUIRE_EQUAL(rates2.standard_deviation, 0.0);
-////}
-////
-////BOOST_AUTO_TEST_CASE(reservations__rates__five_reservations_one_idle__idle_excluded)
-////{
-////    node::settings settings;
-////    settings.sync_peers = 5;
-////    blockchain_fixture blockchain;
-////    header_queue hashes(no_checks);
-////    const auto message = message_factory(4, check42.hash());
-////    hashes.initialize(check42);
-////    BOOST_REQUIRE(hashes.enqueue(message));
-////
-////    reservations reserves(hashes, blockchain, settings);
-////    const auto table = reserves.table();
-////
-////    // normalized rate: 5 / (2 - 1) = 5
-////    performance rate0;
-////    rate0.idle = false;
-////    rate0.events = 5;
-////    rate0.database = 1;
-////    rate0.window = 2;
-////
-////    // This rate is idle, so values must be excluded in rates computation.
-////    performance rate1;
-////    rate1.idle = true;
-////    rate1.events = 42;
-////    rate1.database = 42;
-////    rate1.window = 42;
-////
-////    // normalized rate: 10 / (6 - 1) = 2
-////    performance rate2;
-////    rate2.idle = false;
-////    rate2.events = 10;
-////    rate2.database = 1;
-////    rate2.window = 6;
-////
-////    // normalized rate: 3 / (6 - 3) = 1
-////    performance rate3;
-////    rate3.idle = false;
-////    rate3.events = 3;
-////    rate3.database = 3;
-////    rate3.window = 6;
-////
-////    // normalized rate: 8 / (5 - 3) = 4
-////    performance rate4;
-////    rate4.idle = false;
-////    rate4.events = 8;
-////    rate4.database = 3;
-////    rate4.window = 5;
-////
-////    // Simulate the rate summary on each channel by setting it directly.
-////    table[0]->set_rate(std::move(rate0));
-////    table[1]->set_rate(std::move(rate1));
-////    table[2]->set_rate(std::move(rate2));
-////    table[3]->set_rate(std::move(rate3));
-////    table[4]->set_rate(std::move(rate4));
-////
-////    const auto rates2 = reserves.rates();
-////
-////    // There are three active (non-idle) rows.
-////    BOOST_REQUIRE_EQUAL(rates2.active_count, 4u);
-////
-////    // mean: (5 + 2 + 1 + 4) / 4 = 3
-////    BOOST_REQUIRE_EQUAL(rates2.arithmentic_mean, 3.0);
-////
-////    // deviations: { 3-5=-2, 3-2=1, 3-1=-2, 3-4=-1 }
-////    // variance: ((-2)^2 + 1^2 + 2^2 + (-1)^2) / 4 = 2.5
-////    // standard deviation: sqrt(2.5)
-////    BOOST_REQUIRE_EQUAL(rates2.standard_deviation, std::sqrt(2.5));
-////}
-////
-////BOOST_AUTO_TEST_SUITE_END()
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <bitcoin/node.hpp>
+#include "utility.hpp"
+
+using namespace bc;
+using namespace bc::node;
+using namespace bc::node::test;
+
+BOOST_AUTO_TEST_SUITE(reservations_tests)
+
+// A measured row rate of the specified blocks per millisecond.
+static performance measured(size_t events)
+{
+    return { false, events, 0, 1000 };
+}
+
+// An idle row rate.
+static const performance idle{ true, 0, 0, 0 };
+
+// construct
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__construct__no_hashes__empty_table)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    BOOST_REQUIRE(reserves.table().empty());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__construct__hashes__interleaved_rows)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    const auto table = reserves.table();
+    BOOST_REQUIRE_EQUAL(table.size(), 3u);
+    BOOST_REQUIRE(hashes.empty());
+
+    for (size_t slot = 0; slot < table.size(); ++slot)
+    {
+        size_t height;
+        bool requested;
+        hash_digest hash;
+        BOOST_REQUIRE_EQUAL(table[slot]->slot(), slot);
+        BOOST_REQUIRE_EQUAL(table[slot]->size(), 3u);
+        BOOST_REQUIRE(table[slot]->front(hash, height, requested));
+        BOOST_REQUIRE_EQUAL(height, slot);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reservations__construct__fewer_hashes_than_peers__row_per_hash)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 2);
+    BOOST_REQUIRE_EQUAL(reserves.table().size(), 2u);
+}
+
+// import
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__import__stored__populated)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    BOOST_REQUIRE(reserves.import(std::make_shared<const message::block>(), 0));
+    BOOST_REQUIRE(populated.contains(0));
+    BOOST_REQUIRE(!reserves.failed());
+    BOOST_REQUIRE(reserves.stop());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__import__store_failure__failed)
+{
+    DECLARE_RESERVATIONS(reserves, false, 3, 0);
+    BOOST_REQUIRE(!reserves.import(std::make_shared<const message::block>(), 0));
+    BOOST_REQUIRE(!populated.contains(0));
+    BOOST_REQUIRE(reserves.failed());
+    BOOST_REQUIRE(!reserves.stop());
+}
+
+#if defined(BITPRIM_DB_NEW)
+BOOST_AUTO_TEST_CASE(reservations__import__store_failure__block_retained)
+{
+    DECLARE_RESERVATIONS(reserves, false, 3, 0);
+    BOOST_REQUIRE(!reserves.import(std::make_shared<const message::block>(), 0));
+    BOOST_REQUIRE_EQUAL(blockchain.inserted(), 1u);
+
+    // The failed block is retried first and no block above it is inserted.
+    BOOST_REQUIRE(!reserves.import(std::make_shared<const message::block>(), 1));
+    BOOST_REQUIRE_EQUAL(blockchain.inserted(), 2u);
+    BOOST_REQUIRE(!populated.contains(1));
+}
+#endif
+
+// check
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__check__invalid_block__reassigned_to_live_row)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+
+    // An empty block fails its checks, which run inline when not started.
+    const auto block = std::make_shared<const message::block>();
+    reserves.check(table[0], block, 8);
+    BOOST_REQUIRE(table[0]->toggle_rejected());
+    BOOST_REQUIRE(reserves.drained());
+    BOOST_REQUIRE_EQUAL(table[0]->size() + table[1]->size(), 9u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__check__invalid_block_no_live_rows__listed)
+{
+    DECLARE_RESERVATIONS(reserves, true, 1, 1);
+    const auto table = reserves.table();
+    hash_heights retired;
+    table[0]->retire(retired);
+    BOOST_REQUIRE(table[0]->stopped());
+
+    // The rejecting row has stopped, so the hash is listed again.
+    const auto block = std::make_shared<const message::block>();
+    reserves.check(table[0], block, 0);
+    BOOST_REQUIRE(table[0]->empty());
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+    BOOST_REQUIRE(!reserves.drained());
+
+    // The table is not emptied while a hash is listed.
+    BOOST_REQUIRE(!reserves.remove(table[0]));
+    BOOST_REQUIRE(reserves.table().empty());
+
+    const auto row = reserves.expand();
+    BOOST_REQUIRE(row);
+    BOOST_REQUIRE_EQUAL(row->size(), 1u);
+    BOOST_REQUIRE(reserves.drained());
+}
+
+// expand
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__expand__at_maximum__null)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    BOOST_REQUIRE(!reserves.expand());
+    BOOST_REQUIRE_EQUAL(reserves.table().size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expand__listed_hashes__reserved_row)
+{
+    DECLARE_RESERVATIONS(reserves, true, 4, 9);
+    populate(hashes, 9, 3);
+
+    const auto row = reserves.expand();
+    BOOST_REQUIRE(row);
+    BOOST_REQUIRE_EQUAL(row->slot(), 3u);
+    BOOST_REQUIRE_EQUAL(row->size(), 3u);
+    BOOST_REQUIRE_EQUAL(reserves.table().size(), 4u);
+    BOOST_REQUIRE(hashes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expand__no_listed_hashes__partitioned_row)
+{
+    DECLARE_RESERVATIONS(reserves, true, 4, 9);
+
+    // The upper half of the unrequested hashes of a maximal row is taken.
+    const auto row = reserves.expand();
+    BOOST_REQUIRE(row);
+    BOOST_REQUIRE_EQUAL(row->size(), 2u);
+    BOOST_REQUIRE_EQUAL(reserves.table().size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expand__large_blocks__byte_budget)
+{
+    DECLARE_RESERVATIONS(reserves, true, 4, 0);
+    populate(hashes, 0, 20);
+
+    // The byte budget of a row is four blocks of this size.
+    sizes.record(0, 16 * 1024 * 1024);
+
+    const auto row = reserves.expand();
+    BOOST_REQUIRE(row);
+    BOOST_REQUIRE_EQUAL(row->size(), 4u);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 16u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expand__small_blocks__max_request)
+{
+    DECLARE_RESERVATIONS(reserves, true, 4, 0);
+    populate(hashes, 0, 20);
+    reserves.set_max_request(5);
+
+    const auto row = reserves.expand();
+    BOOST_REQUIRE(row);
+    BOOST_REQUIRE_EQUAL(row->size(), 5u);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 15u);
+}
+
+// populate
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__populate__emptied_row__byte_budget)
+{
+    DECLARE_RESERVATIONS(reserves, true, 4, 0);
+    populate(hashes, 0, 20);
+    sizes.record(0, 16 * 1024 * 1024);
+
+    const auto row = reserves.expand();
+    BOOST_REQUIRE(row);
+
+    for (size_t height = 0; height < 4; ++height)
+        BOOST_REQUIRE(row->discard(block_hash(height)));
+
+    BOOST_REQUIRE(row->empty());
+    BOOST_REQUIRE(reserves.populate(row));
+    BOOST_REQUIRE_EQUAL(row->size(), 4u);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 12u);
+
+    size_t height;
+    bool requested;
+    hash_digest hash;
+    BOOST_REQUIRE(row->front(hash, height, requested));
+    BOOST_REQUIRE_EQUAL(height, 4u);
+}
+
+// contract
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__contract__single_live_row__false)
+{
+    DECLARE_RESERVATIONS(reserves, true, 1, 3);
+    const auto table = reserves.table();
+    BOOST_REQUIRE_EQUAL(table.size(), 1u);
+    table[0]->set_rate(measured(1));
+    BOOST_REQUIRE(!reserves.contract());
+    BOOST_REQUIRE(!table[0]->retired());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__contract__idle_rows__false)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    BOOST_REQUIRE(!reserves.contract());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__contract__slowest__retired_and_reassigned)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    const auto table = reserves.table();
+    table[0]->set_rate(measured(10));
+    table[1]->set_rate(measured(1));
+    table[2]->set_rate(measured(10));
+
+    BOOST_REQUIRE(reserves.contract());
+    BOOST_REQUIRE(table[1]->retired());
+    BOOST_REQUIRE(table[1]->stopped());
+    BOOST_REQUIRE(table[1]->empty());
+
+    // The retired hashes go to the live rows, not back to the hash list.
+    BOOST_REQUIRE(hashes.empty());
+    BOOST_REQUIRE_EQUAL(table[0]->size() + table[2]->size(), 9u);
+    BOOST_REQUIRE_EQUAL(reserves.table().size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__contract__to_one_live_row__false)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    const auto table = reserves.table();
+    table[0]->set_rate(measured(1));
+    table[1]->set_rate(measured(5));
+    table[2]->set_rate(measured(10));
+
+    BOOST_REQUIRE(reserves.contract());
+    BOOST_REQUIRE(table[0]->retired());
+    BOOST_REQUIRE(reserves.contract());
+    BOOST_REQUIRE(table[1]->retired());
+
+    // The last live row is retained to reserve the remaining hashes.
+    BOOST_REQUIRE(!reserves.contract());
+    BOOST_REQUIRE(!table[2]->retired());
+    BOOST_REQUIRE_EQUAL(table[2]->size(), 9u);
+}
+
+#if defined(BITPRIM_DB_NEW)
+BOOST_AUTO_TEST_CASE(reservations__contract__saturated__next_height_requested)
+{
+    DECLARE_SATURABLE_RESERVATIONS(reserves, 2, 8);
+    const auto table = reserves.table();
+
+    // A block above the next commit height saturates the reorder buffer.
+    BOOST_REQUIRE(reserves.import(std::make_shared<const message::block>(), 7));
+    BOOST_REQUIRE_EQUAL(reserves.request_ceiling(), 0u);
+    BOOST_REQUIRE(table[1]->request(false).inventories().empty());
+
+    table[0]->set_rate(measured(1));
+    table[1]->set_rate(measured(10));
+    BOOST_REQUIRE(reserves.contract());
+    BOOST_REQUIRE(table[0]->retired());
+    BOOST_REQUIRE_EQUAL(table[1]->size(), 8u);
+
+    // The retired next commit height is requested by the remaining row.
+    const auto request = table[1]->request(false);
+    BOOST_REQUIRE_EQUAL(request.inventories().size(), 1u);
+    BOOST_REQUIRE(request.inventories().front().hash() == block_hash(0));
+}
+#endif
+
+// rescue
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__rescue__no_stalls__none)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    table[0]->set_rate(measured(1));
+    table[1]->set_rate(measured(10));
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 0u);
+}
+
+#if defined(BITPRIM_DB_NEW)
+BOOST_AUTO_TEST_CASE(reservations__rescue__saturated_next_height_listed__fastest_row)
+{
+    DECLARE_SATURABLE_RESERVATIONS(reserves, 2, 8);
+    const auto table = reserves.table();
+
+    // Return the next commit height to the hash list.
+    BOOST_REQUIRE(table[0]->discard(block_hash(0)));
+    hashes.restore(block_hash(0), 0);
+
+    BOOST_REQUIRE(reserves.import(std::make_shared<const message::block>(), 7));
+    table[0]->set_rate(measured(1));
+    table[1]->set_rate(measured(10));
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+    BOOST_REQUIRE(hashes.empty());
+
+    size_t height;
+    bool requested;
+    hash_digest hash;
+    BOOST_REQUIRE(table[1]->front(hash, height, requested));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+    BOOST_REQUIRE(!requested);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rescue__unsaturated_next_height_listed__none)
+{
+    DECLARE_SATURABLE_RESERVATIONS(reserves, 2, 8);
+    const auto table = reserves.table();
+    BOOST_REQUIRE(table[0]->discard(block_hash(0)));
+    hashes.restore(block_hash(0), 0);
+    table[1]->set_rate(measured(10));
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 0u);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+}
+#endif
+
+// Request the blocks of the idle first row and let them stall, with the
+// second row measured as active.
+static void stall_first_row(const reservation::list& table)
+{
+    BOOST_REQUIRE(!table[0]->request(false).inventories().empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    table[1]->set_rate(measured(10));
+    BOOST_REQUIRE(table[0]->stalled());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rescue__stalled_row__lowest_to_fastest_row)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    stall_first_row(table);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+
+    size_t height;
+    bool requested;
+    hash_digest hash;
+    BOOST_REQUIRE(table[1]->front(hash, height, requested));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+    BOOST_REQUIRE(hash == block_hash(0));
+    BOOST_REQUIRE(!requested);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rescue__already_rescued__none)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    stall_first_row(table);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 0u);
+    BOOST_REQUIRE_EQUAL(table[1]->size(), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rescue__thief_removed__rescued_again)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    const auto table = reserves.table();
+    table[2]->set_rate(measured(5));
+    stall_first_row(table);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+
+    // The entry of the removed thief no longer blocks another rescue.
+    BOOST_REQUIRE(!reserves.remove(table[1]));
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+
+    size_t height;
+    bool requested;
+    hash_digest hash;
+    BOOST_REQUIRE(table[2]->front(hash, height, requested));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__contract__thief_retired__copy_dropped)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    stall_first_row(table);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+
+    table[0]->set_rate(measured(10));
+    table[1]->set_rate(measured(1));
+    BOOST_REQUIRE(reserves.contract());
+    BOOST_REQUIRE(table[1]->retired());
+
+    // The holder is not handed its own height again.
+    BOOST_REQUIRE_EQUAL(table[0]->size(), 8u);
+    BOOST_REQUIRE(hashes.empty());
+
+    // No entry remains, so the arrival at the holder discards nothing.
+    BOOST_REQUIRE(reserves.resolve(table[0], block_hash(0), 0));
+    BOOST_REQUIRE_EQUAL(table[0]->size(), 8u);
+}
+
+// resolve
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__resolve__not_duplicated__true)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    BOOST_REQUIRE(reserves.resolve(table[0], block_hash(2), 2));
+    BOOST_REQUIRE_EQUAL(table[0]->size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__resolve__duplicated__other_discarded)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    stall_first_row(table);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+
+    // The rescuing row receives first, so the stalled request is dropped.
+    BOOST_REQUIRE(table[1]->discard(block_hash(0)));
+    BOOST_REQUIRE(reserves.resolve(table[1], block_hash(0), 0));
+    BOOST_REQUIRE(!table[0]->discard(block_hash(0)));
+    BOOST_REQUIRE_EQUAL(table[0]->size(), 3u);
+
+    // The duplicate entry is cleared once resolved.
+    BOOST_REQUIRE(reserves.resolve(table[0], block_hash(0), 0));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__resolve__both_received__second_rejected)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 8);
+    const auto table = reserves.table();
+    stall_first_row(table);
+    BOOST_REQUIRE_EQUAL(reserves.rescue(), 1u);
+
+    // Both rows receive the block before either resolves it.
+    BOOST_REQUIRE(table[0]->discard(block_hash(0)));
+    BOOST_REQUIRE(table[1]->discard(block_hash(0)));
+    BOOST_REQUIRE(reserves.resolve(table[1], block_hash(0), 0));
+    BOOST_REQUIRE(!reserves.resolve(table[0], block_hash(0), 0));
+
+    // The duplicate entry is cleared once rejected.
+    BOOST_REQUIRE(reserves.resolve(table[0], block_hash(0), 0));
+}
+
+// rates
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__rates__no_updates__empty)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    const auto rates = reserves.rates();
+    BOOST_REQUIRE_EQUAL(rates.active_count, 0u);
+    BOOST_REQUIRE_EQUAL(rates.arithmentic_mean, 0.0);
+    BOOST_REQUIRE_EQUAL(rates.standard_deviation, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rates__one_active__no_deviation)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    reserves.update_rates(idle, measured(10));
+    const auto rates = reserves.rates();
+    BOOST_REQUIRE_EQUAL(rates.active_count, 1u);
+    BOOST_REQUIRE_EQUAL(rates.arithmentic_mean, measured(10).normal());
+    BOOST_REQUIRE_EQUAL(rates.standard_deviation, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rates__two_active__mean_and_deviation)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    reserves.update_rates(idle, measured(10));
+    reserves.update_rates(idle, measured(30));
+    const auto rates = reserves.rates();
+    BOOST_REQUIRE_EQUAL(rates.active_count, 2u);
+    BOOST_REQUIRE_CLOSE(rates.arithmentic_mean, 0.02, 0.001);
+    BOOST_REQUIRE_CLOSE(rates.standard_deviation, 0.01, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rates__replaced__prior_removed)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    reserves.update_rates(idle, measured(10));
+    reserves.update_rates(measured(10), measured(30));
+    const auto rates = reserves.rates();
+    BOOST_REQUIRE_EQUAL(rates.active_count, 1u);
+    BOOST_REQUIRE_CLOSE(rates.arithmentic_mean, 0.03, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__rates__all_idle__cleared)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 0);
+    reserves.update_rates(idle, measured(10));
+    reserves.update_rates(idle, measured(30));
+    reserves.update_rates(measured(10), idle);
+    reserves.update_rates(measured(30), idle);
+    const auto rates = reserves.rates();
+    BOOST_REQUIRE_EQUAL(rates.active_count, 0u);
+    BOOST_REQUIRE_EQUAL(rates.arithmentic_mean, 0.0);
+    BOOST_REQUIRE_EQUAL(rates.standard_deviation, 0.0);
+    BOOST_REQUIRE_EQUAL(rates.throughput, 0.0);
+}
+
+// remove
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__remove__active_row__rate_withdrawn)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    const auto table = reserves.table();
+    table[0]->set_rate(measured(10));
+    table[1]->set_rate(measured(20));
+    BOOST_REQUIRE_EQUAL(reserves.rates().active_count, 2u);
+
+    BOOST_REQUIRE(!reserves.remove(table[0]));
+    BOOST_REQUIRE_EQUAL(reserves.rates().active_count, 1u);
+
+    // A late update from the removed row is not summarized.
+    table[0]->set_rate(measured(30));
+    const auto rates = reserves.rates();
+    BOOST_REQUIRE_EQUAL(rates.active_count, 1u);
+    BOOST_REQUIRE_CLOSE(rates.arithmentic_mean, 0.02, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__remove__absent__false)
+{
+    DECLARE_RESERVATIONS(reserves, true, 3, 9);
+    const auto other = std::make_shared<reservation>(reserves, 42, 0, 4);
+    BOOST_REQUIRE(!reserves.remove(other));
+    BOOST_REQUIRE_EQUAL(reserves.table().size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__remove__last__emptied)
+{
+    DECLARE_RESERVATIONS(reserves, true, 2, 2);
+    const auto table = reserves.table();
+    BOOST_REQUIRE(!reserves.remove(table[0]));
+    BOOST_REQUIRE(reserves.remove(table[1]));
+    BOOST_REQUIRE(reserves.table().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -31,6 +31,8 @@ BOOST_AUTO_TEST_CASE(settings__construct__default_context__expected)
     node::settings configuration;
     BOOST_REQUIRE_EQUAL(configuration.sync_peers, 0u);
     BOOST_REQUIRE_EQUAL(configuration.sync_timeout_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_window, 64u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_relaxed, true);
     BOOST_REQUIRE_EQUAL(configuration.refresh_transactions, true);
 }
 
@@ -39,6 +41,8 @@ BOOST_AUTO_TEST_CASE(settings__construct__none_context__expected)
     node::settings configuration(config::settings::none);
     BOOST_REQUIRE_EQUAL(configuration.sync_peers, 0u);
     BOOST_REQUIRE_EQUAL(configuration.sync_timeout_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_window, 64u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_relaxed, true);
     BOOST_REQUIRE_EQUAL(configuration.refresh_transactions, true);
 }
 
@@ -47,6 +51,8 @@ BOOST_AUTO_TEST_CASE(settings__construct__mainnet_context__expected)
     node::settings configuration(config::settings::mainnet);
     BOOST_REQUIRE_EQUAL(configuration.sync_peers, 0u);
     BOOST_REQUIRE_EQUAL(configuration.sync_timeout_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_window, 64u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_relaxed, true);
     BOOST_REQUIRE_EQUAL(configuration.refresh_transactions, true);
 }
 
@@ -55,6 +61,8 @@ BOOST_AUTO_TEST_CASE(settings__construct__testnet_context__expected)
     node::settings configuration(config::settings::testnet);
     BOOST_REQUIRE_EQUAL(configuration.sync_peers, 0u);
     BOOST_REQUIRE_EQUAL(configuration.sync_timeout_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_window, 64u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_relaxed, true);
     BOOST_REQUIRE_EQUAL(configuration.refresh_transactions, true);
 }
 
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(size_profile_tests)
+
+static const auto profile_file = "size_profile_test";
+
+BOOST_AUTO_TEST_CASE(size_profile__estimate__default__shipped)
+{
+    const size_profile instance;
+    BOOST_REQUIRE_EQUAL(instance.estimate(0), size_profile::shipped(0));
+    BOOST_REQUIRE_EQUAL(instance.estimate(300000),
+        size_profile::shipped(300000));
+}
+
+BOOST_AUTO_TEST_CASE(size_profile__shipped__heights__nondecreasing)
+{
+    auto prior = size_profile::shipped(0);
+    BOOST_REQUIRE_GT(prior, 0u);
+
+    for (size_t height = 1000; height < 600000; height += 1000)
+    {
+        const auto next = size_profile::shipped(height);
+        BOOST_REQUIRE_GE(next, prior);
+        prior = next;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(size_profile__shipped__beyond_profile__last_size)
+{
+    BOOST_REQUIRE_EQUAL(size_profile::shipped(1000000),
+        size_profile::shipped(10000000));
+}
+
+BOOST_AUTO_TEST_CASE(size_profile__record__interval__mean_of_interval)
+{
+    size_profile instance;
+    const auto base = 10 * size_profile::interval;
+    instance.record(base, 100);
+    instance.record(base + 1, 300);
+
+    BOOST_REQUIRE_EQUAL(instance.estimate(base + 2), 200u);
+    BOOST_REQUIRE_EQUAL(instance.estimate(base - 1),
+        size_profile::shipped(base - 1));
+    BOOST_REQUIRE_EQUAL(instance.estimate(base + size_profile::interval),
+        size_profile::shipped(base + size_profile::interval));
+}
+
+BOOST_AUTO_TEST_CASE(size_profile__estimate__not_mainnet__flat)
+{
+    size_profile instance(profile_file, false);
+    BOOST_REQUIRE_EQUAL(instance.estimate(0), instance.estimate(450000));
+    BOOST_REQUIRE_LT(instance.estimate(450000),
+        size_profile::shipped(450000));
+
+    instance.record(450000, 300);
+    BOOST_REQUIRE_EQUAL(instance.estimate(450000), 300u);
+}
+
+BOOST_AUTO_TEST_CASE(size_profile__load__saved__learned_restored)
+{
+    boost::filesystem::remove(profile_file);
+    const auto base = 20 * size_profile::interval;
+
+    size_profile writer(profile_file, false);
+    BOOST_REQUIRE(!writer.load());
+    writer.record(base, 100);
+    writer.record(base + 1, 300);
+    BOOST_REQUIRE(writer.save());
+
+    size_profile reader(profile_file, false);
+    BOOST_REQUIRE(reader.load());
+    BOOST_REQUIRE_EQUAL(reader.estimate(base + 2), 200u);
+    BOOST_REQUIRE_EQUAL(reader.estimate(0), writer.estimate(0));
+}
+
+BOOST_AUTO_TEST_CASE(size_profile__save__nothing_learned__file_retained)
+{
+    size_profile writer(profile_file, true);
+    writer.record(0, 100);
+    BOOST_REQUIRE(writer.save());
+
+    const size_profile empty(profile_file, true);
+    BOOST_REQUIRE(empty.save());
+
+    size_profile reader(profile_file, true);
+    BOOST_REQUIRE(reader.load());
+    BOOST_REQUIRE_EQUAL(reader.estimate(0), 100u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
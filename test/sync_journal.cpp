@@ -0,0 +1,297 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <boost/filesystem.hpp>
+#include <bitcoin/node.hpp>
+#include "utility.hpp"
+
+using namespace bc;
+using namespace bc::config;
+using namespace bc::node;
+using namespace bc::node::test;
+
+BOOST_AUTO_TEST_SUITE(sync_journal_tests)
+
+static const auto journal_file = "sync_journal_test";
+static const auto journal_log = "sync_journal_test.log";
+
+static hash_digest hash_of(size_t height)
+{
+    return bitcoin_hash(to_chunk(to_little_endian(height)));
+}
+
+static const checkpoint last_check(hash_of(100), 100);
+static const height_bitmap no_bitmap("sync_journal_bitmap_test");
+
+// Reserve heights 5-7 with the hashes of 5 and 6 known.
+static void populate(check_list& hashes)
+{
+    hashes.reserve({ 5, 6, 7 });
+    hashes.enqueue(hash_of(5), 5);
+    hashes.enqueue(hash_of(6), 6);
+}
+
+// A chain that stores the reserved heights in order, reflected in its top and
+// in the bitmap of populated heights.
+class stored_fixture
+  : public blockchain_fixture
+{
+public:
+    stored_fixture()
+      : top_(4), populated_("sync_journal_bitmap_test")
+    {
+        populated_.assign({ 5, 6, 7 }, 10);
+    }
+
+    bool get_last_height(size_t& out_height) const override
+    {
+        out_height = top_;
+        return true;
+    }
+
+    const height_bitmap& populated() const
+    {
+        return populated_;
+    }
+
+    void store(size_t height)
+    {
+        top_ = height;
+        populated_.set(height);
+    }
+
+private:
+    size_t top_;
+    height_bitmap populated_;
+};
+
+BOOST_AUTO_TEST_CASE(sync_journal__load__no_file__false)
+{
+    boost::filesystem::remove(journal_file);
+    blockchain_fixture chain;
+    check_list hashes;
+    sync_journal instance(journal_file, last_check, no_bitmap);
+    BOOST_REQUIRE(!instance.load(hashes, chain));
+    BOOST_REQUIRE(hashes.empty());
+    BOOST_REQUIRE(!instance.captured());
+}
+
+BOOST_AUTO_TEST_CASE(sync_journal__load__saved__restored)
+{
+    blockchain_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, no_bitmap);
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.captured());
+    BOOST_REQUIRE(writer.save(chain));
+
+    check_list hashes;
+    sync_journal reader(journal_file, last_check, no_bitmap);
+    BOOST_REQUIRE(reader.load(hashes, chain));
+    BOOST_REQUIRE_EQUAL(hashes.size(), 3u);
+
+    size_t height;
+    BOOST_REQUIRE(hashes.missing(height));
+    BOOST_REQUIRE_EQUAL(height, 7u);
+
+    hash_digest hash;
+    BOOST_REQUIRE(hashes.dequeue(hash, height));
+    BOOST_REQUIRE_EQUAL(height, 5u);
+    BOOST_REQUIRE(hash == hash_of(5));
+    BOOST_REQUIRE(reader.clear());
+}
+
+BOOST_AUTO_TEST_CASE(sync_journal__load__other_checkpoint__false)
+{
+    blockchain_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, no_bitmap);
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+
+    check_list hashes;
+    sync_journal reader(journal_file, checkpoint(hash_of(200), 200),
+        no_bitmap);
+    BOOST_REQUIRE(!reader.load(hashes, chain));
+    BOOST_REQUIRE(hashes.empty());
+    BOOST_REQUIRE(writer.clear());
+}
+
+BOOST_AUTO_TEST_CASE(sync_journal__save__empty__file_removed)
+{
+    blockchain_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, no_bitmap);
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(boost::filesystem::exists(journal_file));
+
+    writer.capture(check_list{});
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_file));
+}
+
+#if defined(BITPRIM_DB_LEGACY)
+BOOST_AUTO_TEST_CASE(sync_journal__save__populated__pruned)
+{
+    blockchain_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    height_bitmap populated("sync_journal_bitmap_test");
+    populated.assign({ 5, 6, 7 }, 10);
+
+    sync_journal writer(journal_file, last_check, populated);
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+
+    populated.set(5);
+    populated.set(6);
+    BOOST_REQUIRE(writer.save(chain));
+
+    check_list hashes;
+    sync_journal reader(journal_file, last_check, no_bitmap);
+    BOOST_REQUIRE(reader.load(hashes, chain));
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+
+    size_t height;
+    BOOST_REQUIRE(hashes.missing(height));
+    BOOST_REQUIRE_EQUAL(height, 7u);
+    BOOST_REQUIRE(reader.clear());
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(sync_journal__save__unchanged__file_retained)
+{
+    blockchain_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, no_bitmap);
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(boost::filesystem::remove(journal_file));
+
+    // Without a capture or a stored entry the file is not rewritten.
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_file));
+
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(boost::filesystem::exists(journal_file));
+    BOOST_REQUIRE(writer.clear());
+}
+
+BOOST_AUTO_TEST_CASE(sync_journal__save__stored__logged_not_rewritten)
+{
+    stored_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, chain.populated());
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_log));
+    const auto size = boost::filesystem::file_size(journal_file);
+
+    chain.store(5);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(boost::filesystem::exists(journal_log));
+    BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(journal_file), size);
+
+    // The logged height is excluded without a store query.
+    check_list hashes;
+    blockchain_fixture unstored;
+    sync_journal reader(journal_file, last_check, no_bitmap);
+    BOOST_REQUIRE(reader.load(hashes, unstored));
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
+
+    size_t height;
+    hash_digest hash;
+    BOOST_REQUIRE(hashes.dequeue(hash, height));
+    BOOST_REQUIRE_EQUAL(height, 6u);
+    BOOST_REQUIRE(reader.clear());
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_file));
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_log));
+}
+
+BOOST_AUTO_TEST_CASE(sync_journal__save__compact__log_removed)
+{
+    stored_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, chain.populated());
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+
+    chain.store(5);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(boost::filesystem::exists(journal_log));
+    BOOST_REQUIRE(writer.save(chain, true));
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_log));
+
+    check_list hashes;
+    blockchain_fixture unstored;
+    sync_journal reader(journal_file, last_check, no_bitmap);
+    BOOST_REQUIRE(reader.load(hashes, unstored));
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
+    BOOST_REQUIRE(reader.clear());
+}
+
+BOOST_AUTO_TEST_CASE(sync_journal__save__log_exceeds_entries__rewritten)
+{
+    stored_fixture chain;
+    check_list saved;
+    populate(saved);
+
+    sync_journal writer(journal_file, last_check, chain.populated());
+    writer.capture(saved);
+    BOOST_REQUIRE(writer.save(chain));
+
+    chain.store(5);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(boost::filesystem::exists(journal_log));
+
+    // Two logged heights exceed the one remaining entry.
+    chain.store(6);
+    BOOST_REQUIRE(writer.save(chain));
+    BOOST_REQUIRE(!boost::filesystem::exists(journal_log));
+
+    check_list hashes;
+    blockchain_fixture unstored;
+    sync_journal reader(journal_file, last_check, no_bitmap);
+    BOOST_REQUIRE(reader.load(hashes, unstored));
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+
+    size_t height;
+    BOOST_REQUIRE(hashes.missing(height));
+    BOOST_REQUIRE_EQUAL(height, 7u);
+    BOOST_REQUIRE(reader.clear());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -45,6 +45,12 @@ const config::checkpoint check42
 const config::checkpoint::list no_checks;
 const config::checkpoint::list one_check{ check42 };
 
+// Commit each block as it becomes contiguous, saturating once any is buffered.
+const reservations::durability saturable
+{
+    1, 1
+};
+
 // Create a headers message of specified size, starting with a genesis header.
 message::headers::ptr message_factory(size_t count)
 {
@@ -69,10 +75,28 @@ message::headers::ptr message_factory(size_t count,
     return headers;
 }
 
+hash_digest block_hash(size_t height)
+{
+    return bitcoin_hash(to_chunk(to_little_endian(height)));
+}
+
+void populate(check_list& hashes, size_t first, size_t count)
+{
+    check_list::heights heights;
+
+    for (auto height = first; height < first + count; ++height)
+        heights.push_back(height);
+
+    hashes.reserve(heights);
+
+    for (const auto height: heights)
+        hashes.enqueue(block_hash(height), height);
+}
+
 reservation_fixture::reservation_fixture(reservations& reservations,
-    size_t slot, uint32_t sync_timeout_seconds,
+    size_t slot, uint32_t sync_timeout_seconds, size_t window,
     clock::time_point now)
-  : reservation(reservations, slot, sync_timeout_seconds),
+  : reservation(reservations, slot, sync_timeout_seconds, window),
     now_(now)
 {
 }
@@ -84,15 +108,9 @@ std::chrono::microseconds reservation_fixture::rate_window() const
 }
 
 // Accessor
-bool reservation_fixture::pending() const
+size_t reservation_fixture::requested() const
 {
-    return reservation::pending();
-}
-
-// Accessor
-void reservation_fixture::set_pending(bool value)
-{
-    reservation::set_pending(value);
+    return reservation::requested();
 }
 
 // Stub
@@ -107,7 +125,8 @@ blockchain_fixture::blockchain_fixture(bool import_result, size_t gap_trigger,
     size_t gap_height)
   : import_result_(import_result),
     gap_trigger_(gap_trigger),
-    gap_height_(gap_height)
+    gap_height_(gap_height),
+    inserted_(0)
 {
 }
 
@@ -205,6 +224,12 @@ transaction_ptr blockchain_fixture::get_transaction(size_t& out_block_height,
     return nullptr;
 }
 
+bool blockchain_fixture::get_block_hash(hash_digest& out_hash,
+    size_t height) const
+{
+    return false;
+}
+
 bool blockchain_fixture::stub(header_const_ptr header, size_t height)
 {
     return false;
@@ -229,6 +254,29 @@ bool blockchain_fixture::pop(block_const_ptr_list& blocks,
     return false;
 }
 
+bool blockchain_fixture::insert(block_const_ptr block, size_t height)
+{
+    // This prevents a zero import cost, which is useful in testing timeout.
+    std::this_thread::sleep_for(std::chrono::microseconds(1));
+    ++inserted_;
+    return import_result_;
+}
+
+bool blockchain_fixture::begin_insert() const
+{
+    return true;
+}
+
+bool blockchain_fixture::end_insert() const
+{
+    return true;
+}
+
+size_t blockchain_fixture::inserted() const
+{
+    return inserted_;
+}
+
 } // namespace test
 } // namespace node
 } // namespace libbitcoin
@@ -19,6 +19,7 @@
 #ifndef LIBBITCOIN_NODE_TEST_RESERVATIONS_HPP
 #define LIBBITCOIN_NODE_TEST_RESERVATIONS_HPP
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -28,34 +29,64 @@ namespace libbitcoin {
 namespace node {
 namespace test {
 
-#define DECLARE_RESERVATIONS(name, import) \
-config::checkpoint::list checkpoints; \
-header_queue hashes(checkpoints); \
+// Rows of a window of four, stalled once any requested block is outstanding,
+// allocated from the hashes of heights zero through blocks less one.
+#define DECLARE_RESERVATIONS(name, import, peers, blocks) \
+check_list hashes; \
+populate(hashes, 0, blocks); \
+height_bitmap populated("reservations_test"); \
+size_profile sizes; \
 blockchain_fixture blockchain(import); \
 node::settings config; \
-reservations name(hashes, blockchain, config)
+config.sync_peers = peers; \
+config.sync_window = 4; \
+config.sync_timeout_seconds = 0; \
+config.sync_relaxed = false; \
+reservations name(hashes, populated, sizes, blockchain, config)
+
+// As above, with a reorder buffer saturated by any one block above the next
+// commit height.
+#define DECLARE_SATURABLE_RESERVATIONS(name, peers, blocks) \
+check_list hashes; \
+populate(hashes, 0, blocks); \
+height_bitmap populated("reservations_test"); \
+size_profile sizes; \
+blockchain_fixture blockchain; \
+node::settings config; \
+config.sync_peers = peers; \
+config.sync_window = 4; \
+config.sync_timeout_seconds = 0; \
+config.sync_relaxed = false; \
+reservations name(hashes, populated, sizes, blockchain, config, saturable)
 
 extern const config::checkpoint check0;
 extern const config::checkpoint check42;
 extern const config::checkpoint::list no_checks;
 extern const config::checkpoint::list one_check;
+extern const reservations::durability saturable;
 
 // Create a headers message of specified size, using specified previous hash.
 extern message::headers::ptr message_factory(size_t count);
 extern message::headers::ptr message_factory(size_t count,
     const hash_digest& previous);
 
+// A distinct block hash for the height.
+extern hash_digest block_hash(size_t height);
+
+// Reserve and enqueue the hashes of count heights from first.
+extern void populate(check_list& hashes, size_t first, size_t count);
+
 class reservation_fixture
   : public reservation
 {
 public:
     typedef std::chrono::high_resolution_clock clock;
     reservation_fixture(reservations& reservations, size_t slot,
-        uint32_t sync_timeout_seconds, clock::time_point now = clock::now());
+        uint32_t sync_timeout_seconds, size_t window = max_get_data,
+        clock::time_point now = clock::now());
     std::chrono::microseconds rate_window() const;
     clock::time_point now() const override;
-    bool pending() const;
-    void set_pending(bool value);
+    size_t requested() const;
 
 private:
     clock::time_point now_;
@@ -89,6 +120,7 @@ public:
         const hash_digest& transaction_hash) const;
     transaction_ptr get_transaction(size_t& out_block_height,
         const hash_digest& transaction_hash) const;
+    bool get_block_hash(hash_digest& out_hash, size_t height) const;
 
     // Setters.
     // ------------------------------------------------------------------------
@@ -96,11 +128,18 @@ public:
     bool fill(block_const_ptr block, size_t height);
     bool push(const block_const_ptr_list& blocks, size_t height);
     bool pop(block_const_ptr_list& out_blocks, const hash_digest& fork_hash);
+    bool insert(block_const_ptr block, size_t height);
+    bool begin_insert() const;
+    bool end_insert() const;
+
+    // The number of blocks inserted.
+    size_t inserted() const;
 
 private:
     bool import_result_;
     size_t gap_trigger_;
     size_t gap_height_;
+    std::atomic<size_t> inserted_;
 };
 
 } // namespace test